@@ -0,0 +1,91 @@
+/**
+ * @file HcalChannelDeposit.h
+ * @brief Class that stores the simulated energy deposited in one HCal strip
+ */
+
+#ifndef HCAL_EVENT_HCALCHANNELDEPOSIT_H_
+#define HCAL_EVENT_HCALCHANNELDEPOSIT_H_
+
+//----------//
+//   ROOT   //
+//----------//
+#include "TObject.h"  //For ClassDef
+
+namespace ldmx {
+
+/**
+ * @class HcalChannelDeposit
+ * @brief Sim hits of one HCal strip aggregated before digitization
+ *
+ * HcalDigiProducer can write these instead of re-reading the sim hits, so a
+ * scan of the digitization parameters can start from this much smaller
+ * collection. Strips are stored at their native granularity, super strips
+ * are formed when digitizing.
+ */
+class HcalChannelDeposit {
+ public:
+  /** Constructor */
+  HcalChannelDeposit() {}
+
+  /**
+   * Constructor with all of the values.
+   *
+   * @param id Raw HcalID of the strip.
+   * @param edep Total energy deposited [MeV].
+   * @param time Energy weighted time [ns].
+   * @param x Energy weighted x position [mm].
+   * @param y Energy weighted y position [mm].
+   * @param z Energy weighted z position [mm].
+   */
+  HcalChannelDeposit(unsigned int id, float edep, float time, float x, float y,
+                     float z)
+      : id_{id}, edep_{edep}, time_{time}, x_{x}, y_{y}, z_{z} {}
+
+  /** Destructor */
+  ~HcalChannelDeposit() {}
+
+  /** Reset the object. */
+  void Clear();
+
+  /** Print out the object */
+  void Print() const;
+
+  /** @return The raw HcalID of the strip. */
+  unsigned int getID() const { return id_; }
+
+  /** @return The total energy deposited in the strip [MeV]. */
+  float getEdep() const { return edep_; }
+
+  /** @return The energy weighted time [ns]. */
+  float getTime() const { return time_; }
+
+  /** @return The energy weighted x position [mm]. */
+  float getX() const { return x_; }
+
+  /** @return The energy weighted y position [mm]. */
+  float getY() const { return y_; }
+
+  /** @return The energy weighted z position [mm]. */
+  float getZ() const { return z_; }
+
+ private:
+  /** Raw HcalID of the strip. */
+  unsigned int id_{0};
+
+  /** Total energy deposited. */
+  float edep_{0};
+
+  /** Energy weighted time. */
+  float time_{0};
+
+  /** Energy weighted position. */
+  float x_{0};
+  float y_{0};
+  float z_{0};
+
+  ClassDef(HcalChannelDeposit, 1);
+
+};  // HcalChannelDeposit
+}  // namespace ldmx
+
+#endif  // HCAL_EVENT_HCALCHANNELDEPOSIT_H_
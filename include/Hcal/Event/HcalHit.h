@@ -71,6 +71,54 @@ class HcalHit : public CalorimeterHit {
    */
   void setMinPE(float minpe) { minpe_ = minpe; }
 
+  /**
+   * Get the number of photoelectrons seen at the end of the bar on the
+   * positive side (+x for horizontal bars, +y for vertical bars).
+   * @return Number of photoelectrons at the plus end, only set for two sided
+   * readout.
+   */
+  float getPlusEndPE() const { return pe_plus_; }
+
+  /**
+   * Get the number of photoelectrons seen at the end of the bar on the
+   * negative side.
+   * @return Number of photoelectrons at the minus end, only set for two sided
+   * readout.
+   */
+  float getMinusEndPE() const { return pe_minus_; }
+
+  /**
+   * Get the time of the signal at the plus end of the bar.
+   * @return Time [ns] at the plus end, only set for two sided readout.
+   */
+  float getPlusEndTime() const { return time_plus_; }
+
+  /**
+   * Get the time of the signal at the minus end of the bar.
+   * @return Time [ns] at the minus end, only set for two sided readout.
+   */
+  float getMinusEndTime() const { return time_minus_; }
+
+  /**
+   * Set the number of photoelectrons seen at each end of the bar.
+   * @param plus Number of photoelectrons at the plus end.
+   * @param minus Number of photoelectrons at the minus end.
+   */
+  void setEndPE(float plus, float minus) {
+    pe_plus_ = plus;
+    pe_minus_ = minus;
+  }
+
+  /**
+   * Set the time of the signal at each end of the bar.
+   * @param plus Time [ns] at the plus end.
+   * @param minus Time [ns] at the minus end.
+   */
+  void setEndTime(float plus, float minus) {
+    time_plus_ = plus;
+    time_minus_ = minus;
+  }
+
  private:
   /** The number of PE estimated for this hit. */
   float pe_{0};
@@ -79,10 +127,20 @@ class HcalHit : public CalorimeterHit {
    * you have two ended readout */
   float minpe_{-99};
 
+  /** The number of PE at the plus and minus ends of the bar, only set for two
+   * ended readout */
+  float pe_plus_{-99};
+  float pe_minus_{-99};
+
+  /** The time at the plus and minus ends of the bar, only set for two ended
+   * readout */
+  float time_plus_{-99};
+  float time_minus_{-99};
+
   /**
    * The ROOT class definition.
    */
-  ClassDef(HcalHit, 2);
+  ClassDef(HcalHit, 3);
 };
 
 }  // namespace ldmx
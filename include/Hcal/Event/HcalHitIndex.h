@@ -0,0 +1,108 @@
+/**
+ * @file HcalHitIndex.h
+ * @brief Class that indexes a sorted collection of HcalHits by section and
+ *        layer
+ */
+
+#ifndef HCAL_EVENT_HCALHITINDEX_H_
+#define HCAL_EVENT_HCALHITINDEX_H_
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <utility>
+#include <vector>
+
+//----------//
+//   ROOT   //
+//----------//
+#include "TObject.h"  //For ClassDef
+
+namespace ldmx {
+
+/**
+ * @class HcalHitIndex
+ * @brief Offsets of each section and layer in a hit collection sorted by
+ *        (section, layer, strip)
+ *
+ * HcalDigiProducer sorts the HcalRecHits by channel and stores one of these
+ * next to them. A range [first, second) can then be looked up without
+ * scanning the hits, and inside a layer the hits are ordered by strip so a
+ * single channel can be found with a binary search on the hit ID.
+ */
+class HcalHitIndex {
+ public:
+  /** A range of hits [first, second) in the indexed collection. */
+  typedef std::pair<unsigned int, unsigned int> Range;
+
+  /** Constructor */
+  HcalHitIndex() {}
+
+  /** Destructor */
+  ~HcalHitIndex() {}
+
+  /** Reset the object. */
+  void Clear();
+
+  /** Print out the object */
+  void Print() const;
+
+  /**
+   * Start the block of hits of a new layer.
+   *
+   * Layers must be added in (section, layer) order.
+   *
+   * @param section Section of the layer.
+   * @param layer Layer number inside the section.
+   * @param begin Index of the first hit in the layer.
+   */
+  void addLayer(int section, int layer, unsigned int begin);
+
+  /**
+   * Set the total number of hits in the collection, which closes the block
+   * of the last layer.
+   *
+   * @param nHits Number of hits in the indexed collection.
+   */
+  void setNumHits(unsigned int nHits) { nHits_ = nHits; }
+
+  /** @return The number of hits in the indexed collection. */
+  unsigned int getNumHits() const { return nHits_; }
+
+  /**
+   * @param section Section to look up.
+   * @return The range of hits in the section, empty if it has no hits.
+   */
+  Range getSectionRange(int section) const;
+
+  /**
+   * @param section Section of the layer.
+   * @param layer Layer to look up.
+   * @return The range of hits in the layer, empty if it has no hits.
+   */
+  Range getLayerRange(int section, int layer) const;
+
+ private:
+  /** @return The sort key of a layer. */
+  static unsigned int key(int section, int layer) {
+    return (unsigned(section) << 8) | (unsigned(layer) & 0xFF);
+  }
+
+  /** @return The range of hits with keys in [keyBegin, keyEnd). */
+  Range getRange(unsigned int keyBegin, unsigned int keyEnd) const;
+
+  /** Sorted (section, layer) keys of the layers with hits. */
+  std::vector<unsigned int> keys_;
+
+  /** Index of the first hit of each layer in keys_. */
+  std::vector<unsigned int> begins_;
+
+  /** Number of hits in the indexed collection. */
+  unsigned int nHits_{0};
+
+  ClassDef(HcalHitIndex, 1);
+
+};  // HcalHitIndex
+}  // namespace ldmx
+
+#endif  // HCAL_EVENT_HCALHITINDEX_H_
@@ -0,0 +1,146 @@
+/**
+ * @file HcalMipTrack.h
+ * @brief Class that stores a straight MIP track found in the back HCal
+ */
+
+#ifndef HCAL_EVENT_HCALMIPTRACK_H_
+#define HCAL_EVENT_HCALMIPTRACK_H_
+
+//----------//
+//   ROOT   //
+//----------//
+#include "TObject.h"  //For ClassDef
+
+namespace ldmx {
+
+/**
+ * @class HcalMipTrack
+ * @brief Straight MIP track through the back HCal layers
+ *
+ * The track is parameterized as x = x0 + dxdz * (z - z0) and
+ * y = y0 + dydz * (z - z0). The x view is measured by the vertical bars of
+ * the even layers and the y view by the horizontal bars of the odd layers.
+ */
+class HcalMipTrack {
+ public:
+  /** Constructor */
+  HcalMipTrack() {}
+
+  /** Destructor */
+  ~HcalMipTrack() {}
+
+  /** Reset the object. */
+  void Clear();
+
+  /** Print out the object */
+  void Print() const;
+
+  /** @return The reference z position of the track parameters [mm]. */
+  float getZ0() const { return z0_; }
+
+  /** @return The x position of the track at the reference z [mm]. */
+  float getX0() const { return x0_; }
+
+  /** @return The y position of the track at the reference z [mm]. */
+  float getY0() const { return y0_; }
+
+  /** @return The slope dx/dz of the track. */
+  float getDXDZ() const { return dxdz_; }
+
+  /** @return The slope dy/dz of the track. */
+  float getDYDZ() const { return dydz_; }
+
+  /** @return The number of layers with a hit on the track. */
+  int getNLayers() const { return nLayers_; }
+
+  /** @return The number of x view (even) layers on the track. */
+  int getNLayersX() const { return nLayersX_; }
+
+  /** @return The number of y view (odd) layers on the track. */
+  int getNLayersY() const { return nLayersY_; }
+
+  /** @return The first layer with a hit on the track. */
+  int getFirstLayer() const { return firstLayer_; }
+
+  /** @return The last layer with a hit on the track. */
+  int getLastLayer() const { return lastLayer_; }
+
+  /** @return The total PE of the hits on the track. */
+  float getPE() const { return pe_; }
+
+  /**
+   * Set the track parameters.
+   *
+   * @param z0 Reference z position [mm].
+   * @param x0 x position at z0 [mm].
+   * @param y0 y position at z0 [mm].
+   * @param dxdz Slope in the x view.
+   * @param dydz Slope in the y view.
+   */
+  void setParameters(float z0, float x0, float y0, float dxdz, float dydz) {
+    z0_ = z0;
+    x0_ = x0;
+    y0_ = y0;
+    dxdz_ = dxdz;
+    dydz_ = dydz;
+  }
+
+  /**
+   * Set the layer counts of the track.
+   *
+   * @param nLayersX Number of x view layers on the track.
+   * @param nLayersY Number of y view layers on the track.
+   * @param firstLayer First layer with a hit on the track.
+   * @param lastLayer Last layer with a hit on the track.
+   */
+  void setLayers(int nLayersX, int nLayersY, int firstLayer, int lastLayer) {
+    nLayers_ = nLayersX + nLayersY;
+    nLayersX_ = nLayersX;
+    nLayersY_ = nLayersY;
+    firstLayer_ = firstLayer;
+    lastLayer_ = lastLayer;
+  }
+
+  /** @param pe The total PE of the hits on the track. */
+  void setPE(float pe) { pe_ = pe; }
+
+ private:
+  /** Reference z position of the track parameters. */
+  float z0_{0};
+
+  /** x position at z0_. */
+  float x0_{0};
+
+  /** y position at z0_. */
+  float y0_{0};
+
+  /** Slope in the x view. */
+  float dxdz_{0};
+
+  /** Slope in the y view. */
+  float dydz_{0};
+
+  /** Number of layers on the track. */
+  int nLayers_{0};
+
+  /** Number of x view layers on the track. */
+  int nLayersX_{0};
+
+  /** Number of y view layers on the track. */
+  int nLayersY_{0};
+
+  /** First layer on the track. */
+  int firstLayer_{-1};
+
+  /** Last layer on the track. */
+  int lastLayer_{-1};
+
+  /** Total PE of the hits on the track. */
+  float pe_{0};
+
+  ClassDef(HcalMipTrack, 1);
+
+};  // HcalMipTrack
+}  // namespace ldmx
+
+#endif  // HCAL_EVENT_HCALMIPTRACK_H_
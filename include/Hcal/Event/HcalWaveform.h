@@ -0,0 +1,69 @@
+/**
+ * @file HcalWaveform.h
+ * @brief Class that stores the ADC samples of one HCal readout channel
+ */
+
+#ifndef HCAL_EVENT_HCALWAVEFORM_H_
+#define HCAL_EVENT_HCALWAVEFORM_H_
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <vector>
+
+//----------//
+//   ROOT   //
+//----------//
+#include "TObject.h"  //For ClassDef
+
+namespace ldmx {
+
+/**
+ * @class HcalWaveform
+ * @brief ADC samples of one HCal readout channel over the readout window
+ *
+ * Produced by HcalDigiProducer in waveform mode, one per channel with a
+ * signal hit, sorted by channel ID.
+ */
+class HcalWaveform {
+ public:
+  /** Constructor */
+  HcalWaveform() {}
+
+  /**
+   * Constructor with all of the values.
+   *
+   * @param id Raw HcalID of the channel.
+   * @param samples ADC counts of each clock tick.
+   */
+  HcalWaveform(unsigned int id, const std::vector<int>& samples)
+      : id_{id}, samples_{samples} {}
+
+  /** Destructor */
+  ~HcalWaveform() {}
+
+  /** Reset the object. */
+  void Clear();
+
+  /** Print out the object */
+  void Print() const;
+
+  /** @return The raw HcalID of the channel. */
+  unsigned int getID() const { return id_; }
+
+  /** @return The ADC counts of each clock tick. */
+  const std::vector<int>& getSamples() const { return samples_; }
+
+ private:
+  /** Raw HcalID of the channel. */
+  unsigned int id_{0};
+
+  /** ADC counts of each clock tick. */
+  std::vector<int> samples_;
+
+  ClassDef(HcalWaveform, 1);
+
+};  // HcalWaveform
+}  // namespace ldmx
+
+#endif  // HCAL_EVENT_HCALWAVEFORM_H_
@@ -0,0 +1,149 @@
+/**
+ * @file HcalChannelMask.h
+ * @brief Conditions object flagging dead, hot and noisy HCal channels
+ */
+
+#ifndef HCAL_HCALCHANNELMASK_H_
+#define HCAL_HCALCHANNELMASK_H_
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------//
+//   LDMX   //
+//----------//
+#include "Framework/ConditionsObject.h"
+#include "Framework/ConditionsObjectProvider.h"
+#include "Framework/Configure/Parameters.h"
+
+namespace ldmx {
+
+/**
+ * @class HcalChannelMask
+ * @brief Bitsets of the dead, hot and noise-scaled HCal readout channels
+ *
+ * Channels are numbered compactly section by section, then by layer and
+ * strip, using the readout granularity (super strips in the back HCal).
+ * Each flag is stored as a bitset over that numbering so that a lookup is a
+ * single bit test. Dead and hot channels are also merged into one "masked"
+ * bitset, these channels are dropped from the readout.
+ *
+ * Like the RandomNumberSeedService, this class is its own provider and is
+ * valid for all runs.
+ */
+class HcalChannelMask : public ConditionsObject,
+                        public ConditionsObjectProvider {
+ public:
+  /** Name of the conditions object */
+  static const std::string CONDITIONS_OBJECT_NAME;
+
+  /** Number of HCal sections */
+  static const int NUM_SECTIONS{5};
+
+  /** Constructor */
+  HcalChannelMask(const std::string& name, const std::string& tagname,
+                  const Parameters& parameters, Process& process);
+
+  /** Destructor */
+  virtual ~HcalChannelMask() {}
+
+  /**
+   * Provide the mask itself, valid for data and simulation.
+   */
+  virtual std::pair<const ConditionsObject*, ConditionsIOV> getCondition(
+      const EventHeader& context) override;
+
+  /** The mask is owned by the provider, nothing to release. */
+  virtual void releaseConditionsObject(const ConditionsObject* co) override {}
+
+  /**
+   * @param id Raw HcalID of a readout channel.
+   * @return The compact channel number, -1 if outside the configured layout.
+   */
+  int index(unsigned int id) const;
+
+  /** @return True if the channel is dead or hot. */
+  bool isMasked(unsigned int id) const { return test(masked_, id); }
+
+  /** @return True if the channel is dead. */
+  bool isDead(unsigned int id) const { return test(dead_, id); }
+
+  /** @return True if the channel is hot. */
+  bool isHot(unsigned int id) const { return test(hot_, id); }
+
+  /** @return True if the noise of the channel is scaled. */
+  bool isNoiseScaled(unsigned int id) const { return test(noiseScaled_, id); }
+
+  /** @return The factor applied to the noise of noise-scaled channels. */
+  double getNoiseScale() const { return noiseScale_; }
+
+  /** @return The number of layers of the section, 0 if unknown. */
+  int getNumLayers(int section) const;
+
+  /** @return The number of readout strips per layer, 0 if unknown. */
+  int getNumStrips(int section) const;
+
+  /**
+   * @param section HcalID section.
+   * @return The number of dead or hot channels in the section.
+   */
+  int getNumMasked(int section) const;
+
+  /**
+   * @param section HcalID section.
+   * @return The number of noise-scaled channels in the section that are
+   * not masked.
+   */
+  int getNumNoiseScaled(int section) const;
+
+  /**
+   * @return The raw IDs of the noise-scaled channels that are not masked,
+   * sorted.
+   */
+  const std::vector<unsigned int>& getNoiseScaledIDs() const {
+    return noiseScaledIDs_;
+  }
+
+ private:
+  /** Set the bit of each channel in ids, raising if one is out of layout. */
+  void fill(std::vector<uint64_t>& bits, const std::vector<int>& ids);
+
+  /** @return The bit of the channel, false if outside the layout. */
+  bool test(const std::vector<uint64_t>& bits, unsigned int id) const {
+    int i = index(id);
+    return i >= 0 && ((bits[i >> 6] >> (i & 63)) & 1);
+  }
+
+  /** Number of layers and strips per layer of each section. */
+  int numLayers_[NUM_SECTIONS];
+  int numStrips_[NUM_SECTIONS];
+
+  /** First compact channel number of each section. */
+  int sectionOffset_[NUM_SECTIONS + 1];
+
+  /** Number of dead or hot channels in each section. */
+  int numMasked_[NUM_SECTIONS];
+
+  /** Number of noise-scaled channels in each section that are not masked. */
+  int numNoiseScaled_[NUM_SECTIONS];
+
+  /** Raw IDs of the noise-scaled channels that are not masked, sorted. */
+  std::vector<unsigned int> noiseScaledIDs_;
+
+  /** Factor applied to the noise of noise-scaled channels. */
+  double noiseScale_{1.};
+
+  /** The bitsets, one bit per compact channel number. */
+  std::vector<uint64_t> dead_;
+  std::vector<uint64_t> hot_;
+  std::vector<uint64_t> noiseScaled_;
+  std::vector<uint64_t> masked_;
+};
+
+}  // namespace ldmx
+
+#endif  // HCAL_HCALCHANNELMASK_H_
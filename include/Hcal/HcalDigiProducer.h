@@ -17,7 +17,10 @@
 #include "Framework/Configure/Parameters.h"
 #include "Framework/EventDef.h"
 #include "Framework/EventProcessor.h"
-#include "Tools/NoiseGenerator.h"
+#include "Hcal/Event/HcalChannelDeposit.h"
+#include "Hcal/Event/HcalHitIndex.h"
+#include "Hcal/Event/HcalWaveform.h"
+#include "Hcal/HcalChannelMask.h"
 
 namespace ldmx {
 
@@ -38,25 +41,284 @@ class HcalDigiProducer : public Producer {
    */
   void configure(Parameters& parameters) final override;
 
+  /**
+   * Digitize one event, as a batch of one.
+   *
+   * The noise is drawn from a generator of its own, seeded with
+   * "HcalDigiProducer::NoiseGenerator", as counts of noisy ends and arrays
+   * of PE values and positions. This is a different sequence from the
+   * NoiseGenerator used before, so noise hits differ from older outputs
+   * with the same seeds.
+   */
   virtual void produce(Event& event);
 
+  /**
+   * Digitize several events in one call.
+   *
+   * The sim hits of the whole batch are aggregated into one flat array of
+   * channels and the noise of every event is drawn in one loop over the
+   * batch, before the hits are split back into one HcalRecHits collection per
+   * event. Random numbers are drawn in the same order as repeated calls to
+   * produce, so each event is identical to the single-event result under the
+   * same seeds.
+   *
+   * The framework calls produce, which is a batch of one. This is for drivers
+   * that hold several events at once, such as a standalone re-digitization
+   * loop: load the events, pass them here in processing order, and each one
+   * gets its output collections added as if produce had been called on it.
+   *
+   * The hits of each event are sorted by (section, layer, strip) and stored
+   * together with a HcalHitIndex of the section and layer ranges.
+   *
+   * @param events Events to digitize, in processing order.
+   */
+  void produceBatch(const std::vector<Event*>& events);
+
   HcalID generateRandomID(HcalID::HcalSection sec);
   void constructNoiseHit(std::vector<HcalHit>&, HcalID::HcalSection, double,
-                         double, const std::map<unsigned int, float>&,
+                         double, const std::vector<unsigned int>&,
+                         std::unordered_set<unsigned int>&);
+  void constructNoiseHit(std::vector<HcalHit>&, unsigned int, double, double,
                          std::unordered_set<unsigned int>&);
 
  private:
+  /**
+   * Energy deposited in one readout channel of an event.
+   *
+   * The time and positions are edep-weighted sums while the sim hits are
+   * aggregated, and edep-weighted averages afterwards.
+   */
+  struct ChannelDeposit {
+    unsigned int id;
+    float edep;
+    float time;
+    float x;
+    float y;
+    float z;
+  };
+
+  /**
+   * Shape of the pulse template around its peak sample, for one phase of
+   * the pulse start.
+   */
+  struct FitPoint {
+    float ratio;  // (before - after) / peak
+    float delay;  // from the pulse start to the peak sample [ns]
+    float gain;   // peak sample of a unit pulse
+  };
+
+  /** A single energy deposit feeding the waveform of a readout channel. */
+  struct Pulse {
+    unsigned int id;
+    float amplitude;  // MeV
+    float time;
+  };
+
+  /**
+   * PE of a noise hit and of its lower end, and its channel for the
+   * noise-scaled channels that have a fixed ID.
+   */
+  struct NoisePE {
+    double pe;
+    double minPE;
+    unsigned int id{0};
+  };
+
+  /**
+   * Poisson noise of an empty readout end, for the ends with at least one
+   * PE, which are the only ones that make noise hits.
+   */
+  struct NoiseModel {
+    /** Probability that an end has at least one PE. */
+    double probability{0};
+
+    /** Cumulative distribution of the PE of an end with at least one PE. */
+    std::vector<double> cdf;
+
+    /** Tabulate the distribution for the given mean PE. */
+    void setMean(double mean);
+
+    /**
+     * @param u Uniform random number in (0, 1].
+     * @return The PE of an end with at least one PE.
+     */
+    double quantile(double u) const;
+  };
+
+  /** Seed the random number generators if this has not been done yet. */
+  void seedGenerators();
+
+  /**
+   * Append the strips hit in the event to channels_, sorted by ID and
+   * averaged over all of the sim hits in each strip.
+   */
+  void aggregateSimHits(Event& event);
+
+  /**
+   * Append the strips of the HcalChannelDeposits collection of the event to
+   * channels_, sorted by ID, instead of aggregating the sim hits.
+   */
+  void loadChannelDeposits(Event& event);
+
+  /**
+   * Add the strips in channels_ from first on to the event as a
+   * HcalChannelDeposits collection.
+   */
+  void writeChannelDeposits(Event& event, std::size_t first);
+
+  /**
+   * Merge the back HCal strips in channels_ from first on into super strips.
+   */
+  void mergeSuperStrips(std::size_t first);
+
+  /**
+   * Simulate the number of PEs in each channel of [begin, end) and add the
+   * ones above threshold to the rec hits.
+   *
+   * In waveform mode the pulses of the channels, sorted by ID, are turned
+   * into ADC samples and the hit time and amplitude come from a fit of the
+   * samples.
+   */
+  void digitizeChannels(const ChannelDeposit* begin, const ChannelDeposit* end,
+                        const Pulse* pulseBegin, const Pulse* pulseEnd,
+                        std::vector<HcalHit>& hcalRecHits,
+                        std::vector<HcalWaveform>& waveforms);
+
+  /**
+   * Map the pulses from first on to readout channels and sort them by ID.
+   */
+  void sortPulses(std::size_t first);
+
+  /**
+   * Sum the shifted and scaled pulse template of each pulse in [begin, end)
+   * into samples_ and digitize it into adcSamples_.
+   *
+   * @param pePerMeV Conversion of the pulse energies into PE, so that the
+   * pulses of a channel add up to the PE it was given by the light yield,
+   * attenuation and Poisson model of the hit.
+   */
+  void fillWaveform(const Pulse* begin, const Pulse* end, double pePerMeV);
+
+  /**
+   * Find the peak of adcSamples_ and look up the delay of the peak sample
+   * and the fraction of the pulse it holds in fitTable_, from the ratio of
+   * its neighbours.
+   *
+   * @param[out] amplitude Pulse amplitude [PE].
+   * @param[out] time Start time of the pulse [ns].
+   * @return False if the waveform has no peak inside the window, the pulse
+   * being empty, too late or started before the window, in which case
+   * amplitude and time are left untouched.
+   */
+  bool fitWaveform(float& amplitude, float& time) const;
+
+  /**
+   * Sort the hits by (section, layer, strip) and fill the index of their
+   * section and layer ranges.
+   */
+  void sortAndIndex(std::vector<HcalHit>& hcalRecHits, HcalHitIndex& index);
+
+  /**
+   * Estimate the position along a back HCal bar from the signals at its two
+   * ends.
+   *
+   * The PE asymmetry is converted to a position with positionTable_ and
+   * combined with the position from the time difference, each weighted by
+   * its expected variance.
+   *
+   * @return Position along the bar [mm], positive towards the plus end.
+   */
+  float reconstructBarPosition(float pe_plus, float pe_minus, float time_plus,
+                               float time_minus) const;
+
+  /**
+   * Draw the noise of the nBackEnds empty back HCal ends and of the nSideTB
+   * and nSideLR empty side HCal channels of an event. The ends of each back
+   * bar are paired and the bars above threshold, then the side channels
+   * with a PE, are appended to noisePE_ as three ranges whose ends are
+   * recorded in noiseOffsets_.
+   */
+  void drawNoise(int nBackEnds, int nSideTB, int nSideLR);
+
+  /**
+   * Draw the noise of the noise-scaled channels without a signal in the
+   * channels [begin, end) of an event and append the ones above threshold
+   * to noisePE_, recording the end of the new range in noiseOffsets_.
+   */
+  void drawScaledNoise(const ChannelDeposit* begin, const ChannelDeposit* end);
+
+  /** Buffers reused between calls to avoid reallocating for each event. */
+  std::vector<ChannelDeposit> channels_;
+  std::vector<std::size_t> channelOffsets_;
+  std::vector<NoisePE> noisePE_;
+  std::vector<std::size_t> noiseOffsets_;
+  std::vector<int> emptyBackChannels_;
+  std::vector<double> noiseUniforms_;
+  std::vector<double> slotUniforms_;
+  std::vector<unsigned int> noiseSlots_;
+  std::vector<unsigned int> signalIDs_;
+  std::vector<std::pair<unsigned int, unsigned int>> sortKeys_;
+  std::vector<HcalHit> sortedHits_;
+  std::vector<Pulse> pulses_;
+  std::vector<std::size_t> pulseOffsets_;
+  std::vector<float> samples_;
+  std::vector<int> adcSamples_;
+
   bool verbose_{false};
   std::unique_ptr<TRandom3> random_{nullptr};
-  std::unique_ptr<NoiseGenerator> noiseGenerator_{nullptr};
+  std::unique_ptr<TRandom3> noiseRandom_{nullptr};
+  NoiseModel noiseModel_;
+  NoiseModel scaledNoiseModel_;
+
+  /** Use the HcalChannelMask condition, and the mask of the current batch. */
+  bool use_channel_mask_{false};
+  const HcalChannelMask* channelMask_{nullptr};
 
   double meanNoise_{0};
   int nProcessed_{0};
   double mev_per_mip_{1.40};
   double pe_per_mip_{13.5};
   double strip_attenuation_length_{100.};
-  double strip_position_resolution_{150.};
+  double strip_time_resolution_{0.5};
+  double strip_light_velocity_{150.};
+  int position_table_size_{1024};
+
+  /**
+   * Position along the bar and its variance times the number of PEs, on a
+   * uniform grid of PE asymmetries (plus - minus) / (plus + minus) in [-1, 1].
+   * Filled at configure so no log is needed per hit.
+   */
+  std::vector<float> positionTable_;
+  std::vector<float> positionVarianceTable_;
+
+  /** Produce ADC samples for each channel and fit them. */
+  bool waveform_mode_{false};
+  int n_samples_{10};
+  double clock_period_{25.};
+  double waveform_start_{-50.};
+  double pulse_shaping_time_{25.};
+  int template_oversampling_{32};
+  double adc_per_pe_{4.};
+
+  /**
+   * Pulse template of unit amplitude, filled at configure. For each of the
+   * template_oversampling_ phases of a pulse start within a clock tick,
+   * 2 * n_samples_ samples starting from the tick of the pulse start, so
+   * pulses starting up to n_samples_ ticks before the window still reach it.
+   */
+  std::vector<float> pulseTemplate_;
+
+  /**
+   * Shape of each phase of pulseTemplate_ around its peak, sorted by ratio,
+   * so the fit is unbiased for a single pulse.
+   */
+  std::vector<FitPoint> fitTable_;
   std::string sim_hit_pass_name_;
+
+  /** Write the aggregated strips, or read them instead of the sim hits. */
+  bool write_channel_deposits_{false};
+  bool use_channel_deposits_{false};
+  std::string channel_deposit_pass_name_;
   int readoutThreshold_{2};
   int STRIPS_BACK_PER_LAYER_{60};
   int NUM_BACK_HCAL_LAYERS_{150};
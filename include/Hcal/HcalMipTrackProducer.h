@@ -0,0 +1,143 @@
+/**
+ * @file HcalMipTrackProducer.h
+ * @brief Producer that finds straight MIP tracks in the back HCal.
+ */
+
+#ifndef HCAL_HCALMIPTRACKPRODUCER_H_
+#define HCAL_HCALMIPTRACKPRODUCER_H_
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <string>
+#include <vector>
+
+//----------//
+//   LDMX   //
+//----------//
+#include "Event/HcalHit.h"
+#include "Event/HcalMipTrack.h"
+#include "Framework/Configure/Parameters.h"
+#include "Framework/EventProcessor.h"
+
+namespace ldmx {
+
+/**
+ * @class HcalMipTrackProducer
+ * @brief Finds straight MIP tracks through the back HCal with a Hough
+ *        transform.
+ *
+ * The even back layers measure x and the odd ones measure y, so each view is
+ * searched separately. The hits vote in a fixed size accumulator of
+ * (slope, intercept at z0) bins, each layer voting at most once per bin so
+ * that a bin counts layers rather than hits. Filling is linear in the number
+ * of hits. The highest bin seeds a candidate: the hits within a road
+ * around it are fit with a straight line, and the accumulator is refilled
+ * without them before looking for the next peak. The road is at least half an
+ * intercept bin wide, so it holds every layer that voted in the bin.
+ * Candidates of the two views are then paired by their overlap in z.
+ */
+class HcalMipTrackProducer : public Producer {
+ public:
+  /** Constructor */
+  HcalMipTrackProducer(const std::string &name, Process &process);
+
+  /** Destructor */
+  ~HcalMipTrackProducer();
+
+  /**
+   * Configure the processor using the given user specified parameters.
+   *
+   * @param parameters Set of parameters used to configure this processor.
+   */
+  void configure(Parameters &parameters) final override;
+
+  /**
+   * Run the processor and add the MIP tracks found in the back HCal to the
+   * event.
+   *
+   * @param event The event to process.
+   */
+  void produce(Event &event);
+
+ private:
+  /** A hit measuring one coordinate at a given z. */
+  struct ViewHit {
+    float z;
+    float u;
+    float pe;
+    int layer;
+    bool used;
+  };
+
+  /** A straight line found in one view. */
+  struct ViewTrack {
+    float u0;
+    float slope;
+    float zMin;
+    float zMax;
+    float pe;
+    int nLayers;
+    int firstLayer;
+    int lastLayer;
+  };
+
+  /**
+   * Fill the accumulator with the votes of the unused hits, which must be
+   * ordered by layer.
+   */
+  void fillAccumulator(const std::vector<ViewHit> &hits);
+
+  /** Find the tracks in one view, appending them to tracks. */
+  void findTracks(std::vector<ViewHit> &hits, std::vector<ViewTrack> &tracks);
+
+  /** Name of the pass that produced the rec hits. */
+  std::string hit_pass_name_;
+
+  /** Minimum PE for a hit to be used. */
+  float minPE_{1};
+
+  /** Reference z of the track intercepts [mm]. */
+  float z0_{2000};
+
+  /** Largest absolute slope searched for. */
+  float maxSlope_{1};
+
+  /** Largest absolute intercept searched for [mm]. */
+  float maxIntercept_{1500};
+
+  /** Number of slope bins in the accumulator. */
+  int nSlopeBins_{64};
+
+  /** Number of intercept bins in the accumulator. */
+  int nInterceptBins_{60};
+
+  /** Half width of the road used to collect the hits of a candidate [mm]. */
+  float roadWidth_{75};
+
+  /** Minimum number of layers per view for a candidate. */
+  int minLayers_{4};
+
+  /** Maximum number of tracks to look for in each view. */
+  int maxTracks_{4};
+
+  /** Slope at the center of each slope bin. */
+  std::vector<float> slopes_;
+
+  /** The Hough accumulator, indexed by slope bin * nInterceptBins_ + bin. */
+  std::vector<int> accumulator_;
+
+  /** Last layer that voted in each accumulator bin. */
+  std::vector<int> voter_;
+
+  /** The hits in the road of a candidate. */
+  std::vector<unsigned int> roadHits_;
+
+  /** Hits and candidates of each view, reused between events. */
+  std::vector<ViewHit> hitsX_, hitsY_;
+  std::vector<ViewTrack> tracksX_, tracksY_;
+
+};  // HcalMipTrackProducer
+}  // namespace ldmx
+
+#endif  // HCAL_HCALMIPTRACKPRODUCER_H_
@@ -11,6 +11,7 @@
 //   C++ StdLib   //
 //----------------//
 #include <string>
+#include <vector>
 
 //----------//
 //   LDMX   //
@@ -19,6 +20,7 @@
 #include "Event/HcalVetoResult.h"
 #include "Framework/Configure/Parameters.h"
 #include "Framework/EventProcessor.h"
+#include "Hcal/HcalChannelMask.h"
 
 namespace ldmx {
 
@@ -58,6 +60,26 @@ class HcalVetoProcessor : public Producer {
   /** The minimum number of PE needed for a hit. */
   float minPE_{1};
 
+  /** Skip the dead and hot channels of the HcalChannelMask condition. */
+  bool useChannelMask_{false};
+
+  /** Number of hits evaluated together in the veto kernel. */
+  static const int LANES{8};
+
+  /** Max PE of an event without any hit passing the cuts. */
+  static constexpr float NO_HIT_PE{-1000};
+
+  /**
+   * Columns of the hit data, reused between events. The back HCal and
+   * masked flags are 0 or 1 so the kernel can multiply by them.
+   */
+  std::vector<float> hitPE_;
+  std::vector<float> hitMinPE_;
+  std::vector<float> hitTime_;
+  std::vector<float> hitZ_;
+  std::vector<float> hitBack_;
+  std::vector<float> hitMasked_;
+
 };  // HcalVetoProcessor
 }  // namespace ldmx
 
@@ -28,8 +28,51 @@ class HcalDigiProducer(ldmxcfg.Producer) :
         self.mev_per_mip = 4.66  # measured 1.4 MeV for a 6mm thick tile, so for 20mm bar = 1.4*20/6
         self.pe_per_mip = 68. # PEs per MIP at 1m (assume 80% attentuation of 1m)
         self.strip_attenuation_length = 5. # this is in m
-        self.strip_position_resolution = 150. # this is in mm
+        self.strip_time_resolution = 0.5 # time resolution at each end of the bar, in ns
+        self.strip_light_velocity = 150. # effective speed of light along the bar, in mm/ns
+        self.position_table_size = 1024 # bins of the PE asymmetry to position table
         self.sim_hit_pass_name = '' #use any pass available
+        self.use_channel_mask = False # requires the HcalChannelMask condition
+        self.write_channel_deposits = False # store the aggregated strips as HcalChannelDeposits
+        self.use_channel_deposits = False # digitize HcalChannelDeposits instead of the sim hits
+        self.channel_deposit_pass_name = '' #use any pass available
+        self.waveform_mode = False # sample each channel and fit the samples for the time and amplitude
+        self.n_samples = 10 # clock ticks in the readout window
+        self.clock_period = 25. # in ns
+        self.waveform_start = -50. # time of the first sample, in ns
+        self.pulse_shaping_time = 25. # peaking time of the CR-RC pulse, in ns
+        self.template_oversampling = 32 # pulse template phases per clock tick
+        self.adc_per_pe = 4.
+
+class HcalChannelMask(ldmxcfg.ConditionsObjectProvider) :
+    """Provider of the mask of dead, hot and noise-scaled HCal channels
+
+    Channels are given as raw HcalIDs at readout granularity, so back HCal
+    strips are super strips. Layers and strips are numbered from 0, and a
+    channel outside the layout raises an exception. The layout must match
+    the HcalDigiProducer, which raises an exception otherwise.
+
+    Examples
+    --------
+        from LDMX.Hcal.hcal import HcalChannelMask
+        mask = HcalChannelMask()
+        mask.dead_channels = [ ... ]
+    """
+
+    def __init__(self) :
+        super().__init__('HcalChannelMask','ldmx::HcalChannelMask','Hcal')
+
+        self.strips_side_lr_per_layer = 12
+        self.num_side_lr_hcal_layers = 26
+        self.strips_side_tb_per_layer = 12
+        self.num_side_tb_hcal_layers = 28
+        self.strips_back_per_layer = 60
+        self.num_back_hcal_layers = 96
+        self.super_strip_size = 1
+        self.dead_channels = [ ]
+        self.hot_channels = [ ]
+        self.noise_scaled_channels = [ ]
+        self.noise_scale = 1. # factor applied to the mean noise of noise-scaled channels
 
 class HcalVetoProcessor(ldmxcfg.Producer) :
     """Configuration for veto in HCal
@@ -49,4 +92,30 @@ class HcalVetoProcessor(ldmxcfg.Producer) :
         self.max_time = 50.0
         self.max_depth = 4000.0
         self.back_min_pe = 1.
+        self.use_channel_mask = False # requires the HcalChannelMask condition
+
+
+class HcalMipTrackProducer(ldmxcfg.Producer) :
+    """Configuration for the MIP track finder in the back HCal
+
+    Sets all parameters to reasonable defaults.
+
+    Examples
+    --------
+        from LDMX.Hcal.hcal import HcalMipTrackProducer
+        p.sequence.append( HcalMipTrackProducer() )
+    """
+
+    def __init__(self,name = 'hcalMipTracks') :
+        super().__init__(name,'ldmx::HcalMipTrackProducer','Hcal')
 
+        self.hit_pass_name = '' #use any pass available
+        self.min_pe = 1.
+        self.z0 = 2000. # reference z of the track intercepts, in mm
+        self.max_slope = 1.
+        self.max_intercept = 1500. # in mm
+        self.n_slope_bins = 64
+        self.n_intercept_bins = 60 # 5 cm intercept bins
+        self.road_width = 75. # in mm, at least max_intercept / n_intercept_bins
+        self.min_layers = 4 # per view
+        self.max_tracks = 4 # per view
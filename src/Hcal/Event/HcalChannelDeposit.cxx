@@ -0,0 +1,31 @@
+/**
+ * @file HcalChannelDeposit.cxx
+ * @brief Class that stores the simulated energy deposited in one HCal strip
+ */
+
+#include "Hcal/Event/HcalChannelDeposit.h"
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <iostream>
+
+ClassImp(ldmx::HcalChannelDeposit)
+
+    namespace ldmx {
+  void HcalChannelDeposit::Clear() {
+    id_ = 0;
+    edep_ = 0;
+    time_ = 0;
+    x_ = 0;
+    y_ = 0;
+    z_ = 0;
+  }
+
+  void HcalChannelDeposit::Print() const {
+    std::cout << "HcalChannelDeposit { "
+              << "id: " << std::hex << id_ << std::dec << ",  edep: " << edep_
+              << "MeV, time: " << time_ << "ns, position: (" << x_ << ", "
+              << y_ << ", " << z_ << ") mm }" << std::endl;
+  }
+}
@@ -10,6 +10,10 @@ ClassImp(ldmx::HcalHit)
     CalorimeterHit::Clear();
     pe_ = 0;
     minpe_ = -99;
+    pe_plus_ = -99;
+    pe_minus_ = -99;
+    time_plus_ = -99;
+    time_minus_ = -99;
   }
 
   void HcalHit::Print() const {
@@ -0,0 +1,58 @@
+/**
+ * @file HcalHitIndex.cxx
+ * @brief Class that indexes a sorted collection of HcalHits by section and
+ *        layer
+ */
+
+#include "Hcal/Event/HcalHitIndex.h"
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <algorithm>
+#include <iostream>
+
+ClassImp(ldmx::HcalHitIndex)
+
+    namespace ldmx {
+  void HcalHitIndex::Clear() {
+    keys_.clear();
+    begins_.clear();
+    nHits_ = 0;
+  }
+
+  void HcalHitIndex::Print() const {
+    std::cout << "[ HcalHitIndex ]: " << nHits_ << " hits in " << keys_.size()
+              << " layers" << std::endl;
+    for (unsigned int i = 0; i < keys_.size(); ++i) {
+      unsigned int end = (i + 1 < keys_.size()) ? begins_[i + 1] : nHits_;
+      std::cout << "  section: " << (keys_[i] >> 8)
+                << ", layer: " << (keys_[i] & 0xFF) << ", hits: ["
+                << begins_[i] << ", " << end << ")" << std::endl;
+    }
+  }
+
+  void HcalHitIndex::addLayer(int section, int layer, unsigned int begin) {
+    keys_.push_back(key(section, layer));
+    begins_.push_back(begin);
+  }
+
+  HcalHitIndex::Range HcalHitIndex::getSectionRange(int section) const {
+    return getRange(key(section, 0), key(section + 1, 0));
+  }
+
+  HcalHitIndex::Range HcalHitIndex::getLayerRange(int section, int layer)
+      const {
+    return getRange(key(section, layer), key(section, layer) + 1);
+  }
+
+  HcalHitIndex::Range HcalHitIndex::getRange(unsigned int keyBegin,
+                                             unsigned int keyEnd) const {
+    auto first = std::lower_bound(keys_.begin(), keys_.end(), keyBegin);
+    auto last = std::lower_bound(first, keys_.end(), keyEnd);
+    auto offset = [this](std::vector<unsigned int>::const_iterator it) {
+      return it == keys_.end() ? nHits_ : begins_[it - keys_.begin()];
+    };
+    return Range(offset(first), offset(last));
+  }
+}
@@ -0,0 +1,38 @@
+/**
+ * @file HcalMipTrack.cxx
+ * @brief Class that stores a straight MIP track found in the back HCal
+ */
+
+#include "Hcal/Event/HcalMipTrack.h"
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <iostream>
+
+ClassImp(ldmx::HcalMipTrack)
+
+    namespace ldmx {
+  void HcalMipTrack::Clear() {
+    z0_ = 0;
+    x0_ = 0;
+    y0_ = 0;
+    dxdz_ = 0;
+    dydz_ = 0;
+    nLayers_ = 0;
+    nLayersX_ = 0;
+    nLayersY_ = 0;
+    firstLayer_ = -1;
+    lastLayer_ = -1;
+    pe_ = 0;
+  }
+
+  void HcalMipTrack::Print() const {
+    std::cout << "HcalMipTrack { "
+              << "z0: " << z0_ << "mm, x0: " << x0_ << "mm, y0: " << y0_
+              << "mm, dx/dz: " << dxdz_ << ", dy/dz: " << dydz_
+              << ", layers: " << nLayers_ << " (" << nLayersX_ << " x, "
+              << nLayersY_ << " y) from " << firstLayer_ << " to "
+              << lastLayer_ << ", pe: " << pe_ << "}" << std::endl;
+  }
+}
@@ -0,0 +1,27 @@
+/**
+ * @file HcalWaveform.cxx
+ * @brief Class that stores the ADC samples of one HCal readout channel
+ */
+
+#include "Hcal/Event/HcalWaveform.h"
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <iostream>
+
+ClassImp(ldmx::HcalWaveform)
+
+    namespace ldmx {
+  void HcalWaveform::Clear() {
+    id_ = 0;
+    samples_.clear();
+  }
+
+  void HcalWaveform::Print() const {
+    std::cout << "HcalWaveform { "
+              << "id: " << std::hex << id_ << std::dec << ", samples:";
+    for (int sample : samples_) std::cout << " " << sample;
+    std::cout << " }" << std::endl;
+  }
+}
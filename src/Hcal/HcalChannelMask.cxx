@@ -0,0 +1,134 @@
+/**
+ * @file HcalChannelMask.cxx
+ * @brief Conditions object flagging dead, hot and noisy HCal channels
+ */
+
+#include "Hcal/HcalChannelMask.h"
+
+//-------------//
+//   ldmx-sw   //
+//-------------//
+#include "DetDescr/HcalID.h"
+#include "Framework/Exception/Exception.h"
+
+namespace ldmx {
+
+const std::string HcalChannelMask::CONDITIONS_OBJECT_NAME = "HcalChannelMask";
+
+HcalChannelMask::HcalChannelMask(const std::string& name,
+                                 const std::string& tagname,
+                                 const Parameters& parameters,
+                                 Process& process)
+    : ConditionsObject(CONDITIONS_OBJECT_NAME),
+      ConditionsObjectProvider(CONDITIONS_OBJECT_NAME, tagname, parameters,
+                               process) {
+  int strips_back = parameters.getParameter<int>("strips_back_per_layer") /
+                    parameters.getParameter<int>("super_strip_size");
+  int layers_back = parameters.getParameter<int>("num_back_hcal_layers");
+  int strips_tb = parameters.getParameter<int>("strips_side_tb_per_layer");
+  int layers_tb = parameters.getParameter<int>("num_side_tb_hcal_layers");
+  int strips_lr = parameters.getParameter<int>("strips_side_lr_per_layer");
+  int layers_lr = parameters.getParameter<int>("num_side_lr_hcal_layers");
+
+  numStrips_[HcalID::BACK] = strips_back;
+  numLayers_[HcalID::BACK] = layers_back;
+  numStrips_[HcalID::TOP] = numStrips_[HcalID::BOTTOM] = strips_tb;
+  numLayers_[HcalID::TOP] = numLayers_[HcalID::BOTTOM] = layers_tb;
+  numStrips_[HcalID::LEFT] = numStrips_[HcalID::RIGHT] = strips_lr;
+  numLayers_[HcalID::LEFT] = numLayers_[HcalID::RIGHT] = layers_lr;
+
+  // layers are numbered from 0, like the IDs drawn for noise hits
+  sectionOffset_[0] = 0;
+  for (int section = 0; section < NUM_SECTIONS; ++section) {
+    sectionOffset_[section + 1] =
+        sectionOffset_[section] + numLayers_[section] * numStrips_[section];
+  }
+
+  std::size_t nWords = (sectionOffset_[NUM_SECTIONS] + 63) / 64;
+  dead_.assign(nWords, 0);
+  hot_.assign(nWords, 0);
+  noiseScaled_.assign(nWords, 0);
+  fill(dead_, parameters.getParameter<std::vector<int>>("dead_channels"));
+  fill(hot_, parameters.getParameter<std::vector<int>>("hot_channels"));
+  fill(noiseScaled_,
+       parameters.getParameter<std::vector<int>>("noise_scaled_channels"));
+  noiseScale_ = parameters.getParameter<double>("noise_scale");
+
+  masked_.resize(nWords);
+  for (std::size_t i = 0; i < nWords; ++i) masked_[i] = dead_[i] | hot_[i];
+
+  // the compact numbering follows the order of the raw IDs, so the list of
+  // noise-scaled channels comes out sorted
+  noiseScaledIDs_.clear();
+  for (int section = 0; section < NUM_SECTIONS; ++section) {
+    numMasked_[section] = 0;
+    numNoiseScaled_[section] = 0;
+    for (int i = sectionOffset_[section]; i < sectionOffset_[section + 1];
+         ++i) {
+      bool masked = (masked_[i >> 6] >> (i & 63)) & 1;
+      bool scaled = (noiseScaled_[i >> 6] >> (i & 63)) & 1;
+      numMasked_[section] += masked;
+      if (!scaled || masked) continue;
+      numNoiseScaled_[section]++;
+      int channel = i - sectionOffset_[section];
+      noiseScaledIDs_.push_back(
+          HcalID(section, channel / numStrips_[section],
+                 channel % numStrips_[section])
+              .raw());
+    }
+  }
+}
+
+std::pair<const ConditionsObject*, ConditionsIOV> HcalChannelMask::getCondition(
+    const EventHeader& context) {
+  return std::make_pair(this, ConditionsIOV(true, true));
+}
+
+int HcalChannelMask::index(unsigned int id) const {
+  HcalID detID(id);
+  int section = detID.section();
+  int layer = detID.layer();
+  int strip = detID.strip();
+  if (section < 0 || section >= NUM_SECTIONS || layer >= numLayers_[section] ||
+      strip >= numStrips_[section])
+    return -1;
+  return sectionOffset_[section] + layer * numStrips_[section] + strip;
+}
+
+int HcalChannelMask::getNumLayers(int section) const {
+  if (section < 0 || section >= NUM_SECTIONS) return 0;
+  return numLayers_[section];
+}
+
+int HcalChannelMask::getNumStrips(int section) const {
+  if (section < 0 || section >= NUM_SECTIONS) return 0;
+  return numStrips_[section];
+}
+
+int HcalChannelMask::getNumMasked(int section) const {
+  if (section < 0 || section >= NUM_SECTIONS) return 0;
+  return numMasked_[section];
+}
+
+int HcalChannelMask::getNumNoiseScaled(int section) const {
+  if (section < 0 || section >= NUM_SECTIONS) return 0;
+  return numNoiseScaled_[section];
+}
+
+void HcalChannelMask::fill(std::vector<uint64_t>& bits,
+                           const std::vector<int>& ids) {
+  for (int id : ids) {
+    int i = index(id);
+    if (i < 0) {
+      EXCEPTION_RAISE("InvalidArg",
+                      "HcalChannelMask channel " + std::to_string(id) +
+                          " is outside the configured layout, layers and "
+                          "strips are numbered from 0.");
+    }
+    bits[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+}
+
+}  // namespace ldmx
+
+DECLARE_CONDITIONS_PROVIDER_NS(ldmx, HcalChannelMask);
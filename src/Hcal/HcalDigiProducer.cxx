@@ -6,6 +6,7 @@
 #include "Framework/RandomNumberSeedService.h"
 #include "Hcal/HcalDigiProducer.h"
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 
@@ -33,13 +34,102 @@ void HcalDigiProducer::configure(Parameters& parameters) {
   pe_per_mip_ = parameters.getParameter<double>("pe_per_mip");
   strip_attenuation_length_ =
       parameters.getParameter<double>("strip_attenuation_length");
-  strip_position_resolution_ =
-      parameters.getParameter<double>("strip_position_resolution");
+  strip_time_resolution_ =
+      parameters.getParameter<double>("strip_time_resolution");
+  strip_light_velocity_ =
+      parameters.getParameter<double>("strip_light_velocity");
+  position_table_size_ = parameters.getParameter<int>("position_table_size");
   sim_hit_pass_name_ =
       parameters.getParameter<std::string>("sim_hit_pass_name");
-  noiseGenerator_ = std::make_unique<NoiseGenerator>(meanNoise_, false);
-  noiseGenerator_->setNoiseThreshold(
-      1);  // hard-code this number, create noise hits for non-zero PEs!
+  use_channel_mask_ = parameters.getParameter<bool>("use_channel_mask");
+  write_channel_deposits_ =
+      parameters.getParameter<bool>("write_channel_deposits");
+  use_channel_deposits_ = parameters.getParameter<bool>("use_channel_deposits");
+  channel_deposit_pass_name_ =
+      parameters.getParameter<std::string>("channel_deposit_pass_name");
+  waveform_mode_ = parameters.getParameter<bool>("waveform_mode");
+  n_samples_ = parameters.getParameter<int>("n_samples");
+  clock_period_ = parameters.getParameter<double>("clock_period");
+  waveform_start_ = parameters.getParameter<double>("waveform_start");
+  pulse_shaping_time_ = parameters.getParameter<double>("pulse_shaping_time");
+  template_oversampling_ =
+      parameters.getParameter<int>("template_oversampling");
+  adc_per_pe_ = parameters.getParameter<double>("adc_per_pe");
+
+  // reading the aggregated strips means there are none to write
+  if (use_channel_deposits_ && write_channel_deposits_) {
+    EXCEPTION_RAISE("InvalidArg",
+                    "use_channel_deposits and write_channel_deposits can't "
+                    "both be enabled, the deposits are already in the input.");
+  }
+
+  // first check if the super strip size divides nicely into the total number of
+  // strips
+  if (STRIPS_BACK_PER_LAYER_ % SUPER_STRIP_SIZE_ != 0) {
+    EXCEPTION_RAISE(
+        "InvalidArg",
+        "The specified superstrip size is not compatible with the total number "
+        "of strips! (Number of strips is not divisible by super strip size)");
+  }
+
+  // The light seen at the two ends of a bar is attenuated as
+  // exp(-(L/2 -+ x) / lambda), so the asymmetry a = (plus - minus) / (plus +
+  // minus) gives x = lambda * atanh(a). Tabulate it once along with the
+  // variance of x from the binomial spread of a, (lambda / (1 - a^2))^2 *
+  // (1 - a^2) / N.
+  float half_total_width = STRIPS_BACK_PER_LAYER_ * 50.0f / 2.0f;
+  double lambda = strip_attenuation_length_ * 1000.;  // in mm
+  positionTable_.resize(position_table_size_ + 1);
+  positionVarianceTable_.resize(position_table_size_ + 1);
+  for (int i = 0; i <= position_table_size_; ++i) {
+    double a = -1. + 2. * i / position_table_size_;
+    double one_minus_a2 = std::max(1. - a * a, 1e-6);
+    double x = lambda * 0.5 * log((1. + a + 1e-12) / (1. - a + 1e-12));
+    positionTable_[i] =
+        std::max(std::min(float(x), half_total_width), -half_total_width);
+    positionVarianceTable_[i] = lambda * lambda / one_minus_a2;
+  }
+
+  // CR-RC pulse shape (t / tau) exp(1 - t / tau), which peaks at 1 for
+  // t = tau, tabulated once so no pulse shape is evaluated per deposit
+  if (waveform_mode_) {
+    int n_template = 2 * n_samples_;
+    pulseTemplate_.resize(template_oversampling_ * n_template);
+    for (int phase = 0; phase < template_oversampling_; ++phase) {
+      for (int j = 0; j < n_template; ++j) {
+        double t = (j - double(phase) / template_oversampling_) * clock_period_;
+        double x = t / pulse_shaping_time_;
+        pulseTemplate_[phase * n_template + j] = (t > 0) ? x * exp(1. - x) : 0.;
+      }
+    }
+
+    // the neighbours of the peak sample, relative to it, tell where the
+    // sampling falls on the pulse, whatever its amplitude
+    fitTable_.clear();
+    for (int phase = 0; phase < template_oversampling_; ++phase) {
+      const float* row = &pulseTemplate_[phase * n_template];
+      int peak = std::max_element(row, row + n_template) - row;
+      if (row[peak] <= 0 || peak == n_template - 1) continue;
+      float before = (peak > 0) ? row[peak - 1] : 0.f;
+      fitTable_.push_back(
+          {(before - row[peak + 1]) / row[peak],
+           float((peak - double(phase) / template_oversampling_) *
+                 clock_period_),
+           row[peak]});
+    }
+    std::sort(fitTable_.begin(), fitTable_.end(),
+              [](const FitPoint& a, const FitPoint& b) {
+                return a.ratio < b.ratio;
+              });
+    if (fitTable_.empty()) {
+      EXCEPTION_RAISE("InvalidArg",
+                      "The pulse template doesn't peak inside the readout "
+                      "window, increase n_samples.");
+    }
+  }
+
+  // create noise hits for non-zero PEs
+  noiseModel_.setMean(meanNoise_);
 }
 
 HcalID HcalDigiProducer::generateRandomID(HcalID::HcalSection sec) {
@@ -67,8 +157,25 @@ HcalID HcalDigiProducer::generateRandomID(HcalID::HcalSection sec) {
 void HcalDigiProducer::constructNoiseHit(
     std::vector<HcalHit>& hcalRecHits, HcalID::HcalSection section,
     double total_noise, double min_noise,
-    const std::map<unsigned int, float>& hcaldetIDEdep,
+    const std::vector<unsigned int>& signalIDs,
     std::unordered_set<unsigned int>& noiseHitIDs) {
+  // signalIDs is sorted, so a binary search is enough to avoid the channels
+  // that already have a signal hit. Noise-scaled channels have their own
+  // noise, drawn at their fixed IDs.
+  unsigned int rawID;
+  do {
+    rawID = generateRandomID(section).raw();
+  } while (std::binary_search(signalIDs.begin(), signalIDs.end(), rawID) ||
+           noiseHitIDs.find(rawID) != noiseHitIDs.end() ||
+           (channelMask_ && (channelMask_->isMasked(rawID) ||
+                             channelMask_->isNoiseScaled(rawID))));
+
+  constructNoiseHit(hcalRecHits, rawID, total_noise, min_noise, noiseHitIDs);
+}
+
+void HcalDigiProducer::constructNoiseHit(
+    std::vector<HcalHit>& hcalRecHits, unsigned int rawID, double total_noise,
+    double min_noise, std::unordered_set<unsigned int>& noiseHitIDs) {
   HcalHit noiseHit;
   noiseHit.setPE(total_noise);
   noiseHit.setMinPE(min_noise);
@@ -78,13 +185,6 @@ void HcalDigiProducer::constructNoiseHit(
   noiseHit.setZPos(0.);
   noiseHit.setTime(-999.);
   noiseHit.setEnergy(total_noise * mev_per_mip_ / pe_per_mip_);
-
-  unsigned int rawID;
-  do {
-    rawID = generateRandomID(section).raw();
-  } while (hcaldetIDEdep.find(rawID) != hcaldetIDEdep.end() ||
-           noiseHitIDs.find(rawID) != noiseHitIDs.end());
-
   noiseHit.setID(rawID);
   noiseHitIDs.insert(rawID);
   noiseHit.setNoise(true);
@@ -92,13 +192,13 @@ void HcalDigiProducer::constructNoiseHit(
   hcalRecHits.push_back(noiseHit);
 }
 
-void HcalDigiProducer::produce(Event& event) {
+void HcalDigiProducer::seedGenerators() {
   // Need to handle seeding on the first event
-  if (!noiseGenerator_->hasSeed()) {
+  if (noiseRandom_.get() == nullptr) {
     const RandomNumberSeedService& rseed =
         getCondition<RandomNumberSeedService>(
             RandomNumberSeedService::CONDITIONS_OBJECT_NAME);
-    noiseGenerator_->seedGenerator(
+    noiseRandom_ = std::make_unique<TRandom3>(
         rseed.getSeed("HcalDigiProducer::NoiseGenerator"));
   }
   if (random_.get() == nullptr) {
@@ -107,84 +207,241 @@ void HcalDigiProducer::produce(Event& event) {
             RandomNumberSeedService::CONDITIONS_OBJECT_NAME);
     random_ = std::make_unique<TRandom3>(rseed.getSeed("HcalDigiProducer"));
   }
+}
 
-  std::map<unsigned int, int> hcalLayerPEs;
-  std::map<unsigned int, int> hcalLayerMinPEs;
-  std::map<unsigned int, float> hcalXpos, hcalYpos, hcalZpos, hcaldetIDEdep,
-      hcaldetIDTime;
-  std::unordered_set<unsigned int> noiseHitIDs;
-  int numSigHits_back = 0, numSigHits_side_tb = 0, numSigHits_side_lr = 0;
-
-  float side_hcal_z0(215.0f);
-  float strip_width(50.0f);
-  float super_strip_width = SUPER_STRIP_SIZE_ * strip_width;
-  float total_super_strips = STRIPS_BACK_PER_LAYER_ /
-                             SUPER_STRIP_SIZE_;  // to help the integer round up
-  float half_total_width = STRIPS_BACK_PER_LAYER_ * strip_width / 2.0f;
-
-  // first check if the super strip size divides nicely into the total number of
-  // strips
-  if (STRIPS_BACK_PER_LAYER_ % SUPER_STRIP_SIZE_ != 0) {
-    EXCEPTION_RAISE(
-        "InvalidArg",
-        "The specified superstrip size is not compatible with the total number "
-        "of strips! (Number of strips is not divisible by super strip size)");
-  }
-
+void HcalDigiProducer::aggregateSimHits(Event& event) {
   // looper over sim hits and aggregate energy depositions for each detID
   auto hcalHits{event.getCollection<SimCalorimeterHit>(
       EventConstants::HCAL_SIM_HITS, sim_hit_pass_name_)};
 
+  std::size_t first = channels_.size();
   for (const SimCalorimeterHit& simHit : hcalHits) {
     int detIDraw = simHit.getID();
-    HcalID detID(detIDraw);
-    int layer = detID.layer();
-    int subsection = detID.section();
-    int strip = detID.strip();
     std::vector<float> position = simHit.getPosition();
 
     if (verbose_) {
-      std::cout << detID << std::endl;
+      std::cout << HcalID(detIDraw) << std::endl;
     }
 
-    // re-assign the strip number based on super strip size -- ONLY FOR Back
-    // Hcal
-    if (SUPER_STRIP_SIZE_ != 1 && subsection == 0) {
-      int newstrip = strip / SUPER_STRIP_SIZE_;
-      detID = HcalID(detID.section(), detID.layer(), newstrip);
-      detIDraw = detID.raw();
+    // the energy weighted averages of the hits in each strip are only the
+    // inputs of the two-ended simulation, the position along the bar is then
+    // reconstructed from the light yield and time at each end.
+    float edep = simHit.getEdep();
+    channels_.push_back({static_cast<unsigned int>(detIDraw), edep,
+                         simHit.getTime() * edep, position[0] * edep,
+                         position[1] * edep, position[2] * edep});
+
+    // each sim hit makes its own pulse in the waveform
+    if (waveform_mode_) {
+      pulses_.push_back(
+          {static_cast<unsigned int>(detIDraw), edep, simHit.getTime()});
     }
+  }
 
-    // for now, we take an energy weighted average of the hit in each stip to
-    // simulate the hit position. will use strip TOF and light yield between
-    // strips to estimate position.
-    if (hcaldetIDEdep.find(detIDraw) == hcaldetIDEdep.end()) {
-      // first hit, initialize
-      hcaldetIDEdep[detIDraw] = simHit.getEdep();
-      hcaldetIDTime[detIDraw] = simHit.getTime() * simHit.getEdep();
-      hcalXpos[detIDraw] = position[0] * simHit.getEdep();
-      hcalYpos[detIDraw] = position[1] * simHit.getEdep();
-      hcalZpos[detIDraw] = position[2] * simHit.getEdep();
+  // group the deposits by channel, keeping the sim hit order inside each
+  // channel so the sums are accumulated in the same order as they arrived
+  std::stable_sort(
+      channels_.begin() + first, channels_.end(),
+      [](const ChannelDeposit& a, const ChannelDeposit& b) {
+        return a.id < b.id;
+      });
+
+  if (channels_.size() == first) return;
+  std::size_t last = first;
+  for (std::size_t i = first + 1; i < channels_.size(); ++i) {
+    ChannelDeposit& channel = channels_[last];
+    if (channels_[i].id == channel.id) {
+      channel.x += channels_[i].x;
+      channel.y += channels_[i].y;
+      channel.z += channels_[i].z;
+      channel.edep += channels_[i].edep;
+      channel.time += channels_[i].time;
     } else {
-      // not first hit, aggregate, and store the largest radius hit
-      hcalXpos[detIDraw] += position[0] * simHit.getEdep();
-      hcalYpos[detIDraw] += position[1] * simHit.getEdep();
-      hcalZpos[detIDraw] += position[2] * simHit.getEdep();
-      hcaldetIDEdep[detIDraw] += simHit.getEdep();
-      hcaldetIDTime[detIDraw] += simHit.getTime() * simHit.getEdep();
+      channels_[++last] = channels_[i];
+    }
+  }
+  channels_.resize(last + 1);
+
+  // turn the sums into energy weighted averages
+  for (std::size_t i = first; i < channels_.size(); ++i) {
+    ChannelDeposit& channel = channels_[i];
+    channel.time = channel.time / channel.edep;
+    channel.x = channel.x / channel.edep;
+    channel.y = channel.y / channel.edep;
+    channel.z = channel.z / channel.edep;
+  }
+}
+
+void HcalDigiProducer::loadChannelDeposits(Event& event) {
+  auto deposits{event.getCollection<HcalChannelDeposit>(
+      "HcalChannelDeposits", channel_deposit_pass_name_)};
+
+  std::size_t first = channels_.size();
+  for (const HcalChannelDeposit& deposit : deposits) {
+    channels_.push_back({deposit.getID(), deposit.getEdep(), deposit.getTime(),
+                         deposit.getX(), deposit.getY(), deposit.getZ()});
+
+    // only the aggregated time is known, so each strip makes a single pulse
+    if (waveform_mode_) {
+      pulses_.push_back(
+          {deposit.getID(), deposit.getEdep(), deposit.getTime()});
+    }
+  }
+
+  // they are written sorted, but don't rely on it
+  std::stable_sort(
+      channels_.begin() + first, channels_.end(),
+      [](const ChannelDeposit& a, const ChannelDeposit& b) {
+        return a.id < b.id;
+      });
+}
+
+void HcalDigiProducer::writeChannelDeposits(Event& event, std::size_t first) {
+  std::vector<HcalChannelDeposit> deposits;
+  deposits.reserve(channels_.size() - first);
+  for (std::size_t i = first; i < channels_.size(); ++i) {
+    const ChannelDeposit& channel = channels_[i];
+    deposits.emplace_back(channel.id, channel.edep, channel.time, channel.x,
+                          channel.y, channel.z);
+  }
+  event.add("HcalChannelDeposits", deposits);
+}
+
+void HcalDigiProducer::mergeSuperStrips(std::size_t first) {
+  if (SUPER_STRIP_SIZE_ == 1 || channels_.size() == first) return;
+
+  // re-assign the strip number based on super strip size -- ONLY FOR Back
+  // Hcal. The strip is the lowest field of the ID, so the channels stay
+  // sorted and the strips of a super strip are next to each other.
+  std::size_t last = first;
+  for (std::size_t i = first; i < channels_.size(); ++i) {
+    ChannelDeposit channel = channels_[i];
+    HcalID detID(channel.id);
+    if (detID.section() == 0) {
+      int newstrip = detID.strip() / SUPER_STRIP_SIZE_;
+      channel.id = HcalID(detID.section(), detID.layer(), newstrip).raw();
+    }
+
+    if (i == first || channel.id != channels_[last].id) {
+      if (i != first) ++last;
+      channels_[last] = channel;
+      continue;
     }
+
+    // energy weighted average of the strips in the super strip
+    ChannelDeposit& merged = channels_[last];
+    float edep = merged.edep + channel.edep;
+    merged.time =
+        (merged.time * merged.edep + channel.time * channel.edep) / edep;
+    merged.x = (merged.x * merged.edep + channel.x * channel.edep) / edep;
+    merged.y = (merged.y * merged.edep + channel.y * channel.edep) / edep;
+    merged.z = (merged.z * merged.edep + channel.z * channel.edep) / edep;
+    merged.edep = edep;
+  }
+  channels_.resize(last + 1);
+}
+
+void HcalDigiProducer::sortPulses(std::size_t first) {
+  if (SUPER_STRIP_SIZE_ != 1) {
+    for (std::size_t i = first; i < pulses_.size(); ++i) {
+      HcalID detID(pulses_[i].id);
+      if (detID.section() != 0) continue;
+      int newstrip = detID.strip() / SUPER_STRIP_SIZE_;
+      pulses_[i].id = HcalID(detID.section(), detID.layer(), newstrip).raw();
+    }
+  }
+  std::stable_sort(pulses_.begin() + first, pulses_.end(),
+                   [](const Pulse& a, const Pulse& b) { return a.id < b.id; });
+}
+
+void HcalDigiProducer::fillWaveform(const Pulse* begin, const Pulse* end,
+                                    double pePerMeV) {
+  int n_template = 2 * n_samples_;
+  samples_.assign(n_samples_, 0.f);
+  for (const Pulse* pulse = begin; pulse != end; ++pulse) {
+    // pulses starting after the window, or so early that they are over
+    // before it, don't contribute
+    double ticks = (pulse->time - waveform_start_) / clock_period_;
+    if (ticks >= n_samples_ || ticks < -n_samples_) continue;
+
+    int tick = int(std::floor(ticks));
+    int phase = std::min(int((ticks - tick) * template_oversampling_),
+                         template_oversampling_ - 1);
+    const float* shape = &pulseTemplate_[phase * n_template];
+    for (int k = std::max(tick, 0); k < n_samples_; ++k)
+      samples_[k] += pulse->amplitude * pePerMeV * shape[k - tick];
   }
 
+  adcSamples_.resize(n_samples_);
+  for (int k = 0; k < n_samples_; ++k)
+    adcSamples_[k] = int(samples_[k] * adc_per_pe_ + 0.5);
+}
+
+bool HcalDigiProducer::fitWaveform(float& amplitude, float& time) const {
+  int peak = std::max_element(adcSamples_.begin(), adcSamples_.end()) -
+             adcSamples_.begin();
+
+  // a maximum on the first or last sample is the tail of a pulse that
+  // started before the window or the rise of one that peaks after it
+  if (adcSamples_[peak] <= 0 || peak == 0 || peak == n_samples_ - 1)
+    return false;
+
+  // interpolate the template shape at the ratio of the neighbours, ratios
+  // outside of the table are clamped to its ends
+  double peakValue = adcSamples_[peak];
+  double ratio = (adcSamples_[peak - 1] - adcSamples_[peak + 1]) / peakValue;
+  auto high = std::lower_bound(
+      fitTable_.begin(), fitTable_.end(), ratio,
+      [](const FitPoint& p, double r) { return p.ratio < r; });
+  double delay, gain;
+  if (high == fitTable_.begin() || high == fitTable_.end()) {
+    const FitPoint& edge =
+        (high == fitTable_.end()) ? fitTable_.back() : fitTable_.front();
+    delay = edge.delay;
+    gain = edge.gain;
+  } else {
+    auto low = high - 1;
+    double w = (ratio - low->ratio) / (high->ratio - low->ratio);
+    delay = low->delay + w * (high->delay - low->delay);
+    gain = low->gain + w * (high->gain - low->gain);
+  }
+
+  amplitude = peakValue / gain / adc_per_pe_;
+  time = waveform_start_ + peak * clock_period_ - delay;
+  return true;
+}
+
+void HcalDigiProducer::digitizeChannels(const ChannelDeposit* begin,
+                                        const ChannelDeposit* end,
+                                        const Pulse* pulseBegin,
+                                        const Pulse* pulseEnd,
+                                        std::vector<HcalHit>& hcalRecHits,
+                                        std::vector<HcalWaveform>& waveforms) {
+  float strip_width(50.0f);
+  float super_strip_width = SUPER_STRIP_SIZE_ * strip_width;
+  float half_total_width = STRIPS_BACK_PER_LAYER_ * strip_width / 2.0f;
+
   // loop over detIDs and simulate number of PEs
-  std::vector<HcalHit> hcalRecHits;
-  for (std::map<unsigned int, float>::iterator it = hcaldetIDEdep.begin();
-       it != hcaldetIDEdep.end(); ++it) {
-    int detIDraw = it->first;
-    double depEnergy = hcaldetIDEdep[detIDraw];
-    hcaldetIDTime[detIDraw] = hcaldetIDTime[detIDraw] / hcaldetIDEdep[detIDraw];
-    hcalXpos[detIDraw] = hcalXpos[detIDraw] / hcaldetIDEdep[detIDraw];
-    hcalYpos[detIDraw] = hcalYpos[detIDraw] / hcaldetIDEdep[detIDraw];
-    hcalZpos[detIDraw] = hcalZpos[detIDraw] / hcaldetIDEdep[detIDraw];
+  const Pulse* pulse = pulseBegin;
+  for (const ChannelDeposit* channel = begin; channel != end; ++channel) {
+    unsigned int detIDraw = channel->id;
+
+    // the pulses are sorted like the channels, find the ones of this channel
+    while (pulse != pulseEnd && pulse->id < detIDraw) ++pulse;
+    const Pulse* channelPulses = pulse;
+    while (pulse != pulseEnd && pulse->id == detIDraw) ++pulse;
+
+    // dead and hot channels are not read out
+    if (channelMask_ && channelMask_->isMasked(detIDraw)) continue;
+    double meanNoise = meanNoise_;
+    if (channelMask_ && channelMask_->isNoiseScaled(detIDraw))
+      meanNoise *= channelMask_->getNoiseScale();
+
+    double depEnergy = channel->edep;
+    float hit_time = channel->time;
+    float hit_xpos = channel->x;
+    float hit_ypos = channel->y;
+    float hit_zpos = channel->z;
     double meanPE = depEnergy / mev_per_mip_ * pe_per_mip_;
 
     HcalID curDetId(detIDraw);
@@ -193,31 +450,20 @@ void HcalDigiProducer::produce(Event& event) {
     int cur_layer = curDetId.layer();
     int cur_strip = curDetId.strip();
 
-    if (curDetId.getSection() == HcalID::BACK)
-      numSigHits_back++;
-    else if (curDetId.getSection() == HcalID::TOP ||
-             curDetId.getSection() == HcalID::BOTTOM)
-      numSigHits_side_tb++;
-    else if (curDetId.getSection() == HcalID::LEFT ||
-             curDetId.getSection() == HcalID::RIGHT)
-      numSigHits_side_lr++;
-    else
-      std::cout
-          << "WARNING [HcalDigiProducer::produce]: HcalSection is not known"
-          << std::endl;
-
     // need to add in a weighting factor eventually, so keep it that way to make
     // sure we don't forget about it
     double energy = depEnergy;
 
     // quantize/smear the position
-    float cur_xpos(hcalXpos[detIDraw]), cur_ypos(hcalYpos[detIDraw]),
-        cur_zpos(hcalZpos[detIDraw]);
+    float cur_xpos(hit_xpos), cur_ypos(hit_ypos), cur_zpos(hit_zpos);
+    int layerPEs, layerMinPEs;
+
+    float PE_plus(-99), PE_minus(-99), time_plus(-99), time_minus(-99);
 
     // for back HCal, get PEs with attentuation
     if (cur_subsection == 0) {
-      float distance_along_bar =
-          (cur_layer % 2) ? fabs(cur_xpos) : fabs(cur_ypos);
+      float position_along_bar = (cur_layer % 2) ? cur_xpos : cur_ypos;
+      float distance_along_bar = fabs(position_along_bar);
 
       // increase the PE count to the case with no attentuation (assuming 80%
       // attenuation on the pe_per_mip number @ 1m)
@@ -229,22 +475,37 @@ void HcalDigiProducer::produce(Event& event) {
       float meanPE_far =
           meanPE * exp(-1. * ((half_total_width + distance_along_bar) / 1000.) /
                        strip_attenuation_length_);
-      float PE_close = random_->Poisson(meanPE_close + meanNoise_);
-      float PE_far = random_->Poisson(meanPE_far + meanNoise_);
-      hcalLayerPEs[detIDraw] = PE_close + PE_far;
-      hcalLayerMinPEs[detIDraw] = std::min(PE_close, PE_far);
+      float PE_close = random_->Poisson(meanPE_close + meanNoise);
+      float PE_far = random_->Poisson(meanPE_far + meanNoise);
+      layerPEs = PE_close + PE_far;
+      layerMinPEs = std::min(PE_close, PE_far);
+
+      // the close end is the one on the same side of the bar as the deposit,
+      // and the light takes longer to reach the far end
+      PE_plus = (position_along_bar >= 0) ? PE_close : PE_far;
+      PE_minus = (position_along_bar >= 0) ? PE_far : PE_close;
+      time_plus = hit_time +
+                  (half_total_width - position_along_bar) /
+                      strip_light_velocity_ +
+                  random_->Gaus(0., strip_time_resolution_);
+      time_minus = hit_time +
+                   (half_total_width + position_along_bar) /
+                       strip_light_velocity_ +
+                   random_->Gaus(0., strip_time_resolution_);
+
+      // the position along the bar is estimated from the two ends
+      float reco_position =
+          reconstructBarPosition(PE_plus, PE_minus, time_plus, time_minus);
 
       if (cur_layer % 2 == 0) {  // even layers, vertical
         cur_xpos =
             (super_strip_width * (float(cur_strip) + 0.5)) - half_total_width;
-        cur_ypos =
-            hcalYpos[detIDraw] + random_->Gaus(0., strip_position_resolution_);
+        cur_ypos = reco_position;
       }
       if (cur_layer % 2 == 1) {  // odd layers, horizontal
         cur_ypos =
             (super_strip_width * (float(cur_strip) + 0.5)) - half_total_width;
-        cur_xpos =
-            hcalXpos[detIDraw] + random_->Gaus(0., strip_position_resolution_);
+        cur_xpos = reco_position;
       }
       cur_xpos =
           std::max(std::min(cur_xpos, half_total_width), -half_total_width);
@@ -259,9 +520,9 @@ void HcalDigiProducer::produce(Event& event) {
     }
     // for sidecal don't worry about attenuation because it's single readout
     else {
-      hcalLayerPEs[detIDraw] =
-          int(meanPE + meanNoise_);  // random_->Poisson(meanPE+meanNoise_);
-      hcalLayerMinPEs[detIDraw] = hcalLayerPEs[detIDraw];
+      layerPEs =
+          int(meanPE + meanNoise);  // random_->Poisson(meanPE+meanNoise);
+      layerMinPEs = layerPEs;
 
       // It looks like LEFT / RIGHT are inverted ?!? LEFT should be + and RIGHT
       // - The gdml file is wrong, left and right are indeed inverted (x,y
@@ -294,96 +555,396 @@ void HcalDigiProducer::produce(Event& event) {
       // side_hcal_xy_offset+(cur_layer-1)*back_hcal_layer_thickness;
     }
 
-    if (hcalLayerPEs[detIDraw] >= readoutThreshold_) {
+    if (layerPEs >= readoutThreshold_) {
       HcalHit hit;
       hit.setID(detIDraw);
-      hit.setPE(hcalLayerPEs[detIDraw]);
-      hit.setMinPE(hcalLayerMinPEs[detIDraw]);
-      hit.setAmplitude(hcalLayerPEs[detIDraw]);
+      hit.setPE(layerPEs);
+      hit.setMinPE(layerMinPEs);
+      hit.setEndPE(PE_plus, PE_minus);
+      hit.setEndTime(time_plus, time_minus);
+      hit.setAmplitude(layerPEs);
       hit.setEnergy(energy);
-      hit.setTime(hcaldetIDTime[detIDraw]);
-      hit.setXPos(cur_xpos);  // quantized and smeared positions
-      hit.setYPos(cur_ypos);  // quantized and smeared positions
+      hit.setTime(hit_time);
+      hit.setXPos(cur_xpos);  // quantized and reconstructed positions
+      hit.setYPos(cur_ypos);  // quantized and reconstructed positions
       hit.setZPos(cur_zpos);
       hit.setNoise(false);
 
+      // the time and amplitude are measured from the sampled waveform, a
+      // pulse without a peak inside the window keeps the aggregated ones.
+      // The deposits share the PE of the hit in proportion to their energy,
+      // so the fitted amplitude follows the same PE model as setPE.
+      if (waveform_mode_) {
+        double pePerMeV = (depEnergy > 0) ? layerPEs / depEnergy : 0.;
+        fillWaveform(channelPulses, pulse, pePerMeV);
+        float amplitude, time;
+        if (fitWaveform(amplitude, time)) {
+          hit.setAmplitude(amplitude);
+          hit.setTime(time);
+        }
+        waveforms.emplace_back(detIDraw, adcSamples_);
+      }
+
       hcalRecHits.push_back(hit);
     }
 
     if (verbose_) {
-      HcalID detID(detIDraw);
-
-      int layer = detID.layer();
-      int subsection = detID.section();
-      int strip = detID.strip();
-
       std::cout << "detID     : " << detIDraw << std::endl;
-      std::cout << "Layer     : " << layer << std::endl;
-      std::cout << "Subsection: " << subsection << std::endl;
-      std::cout << "Strip: " << strip << std::endl;
-      std::cout << "Edep: " << hcaldetIDEdep[detIDraw] << std::endl;
-      std::cout << "numPEs: " << hcalLayerPEs[detIDraw] << std::endl;
-      std::cout << "time: " << hcaldetIDTime[detIDraw] << std::endl;
-      std::cout << "z: " << hcalZpos[detIDraw] << std::endl;
-      std::cout << "Layer: " << layer << "\t Strip: " << strip
-                << "\t X: " << hcalXpos[detIDraw]
-                << "\t Y: " << hcalYpos[detIDraw]
-                << "\t Z: " << hcalZpos[detIDraw] << std::endl;
+      std::cout << "Layer     : " << cur_layer << std::endl;
+      std::cout << "Subsection: " << cur_subsection << std::endl;
+      std::cout << "Strip: " << cur_strip << std::endl;
+      std::cout << "Edep: " << channel->edep << std::endl;
+      std::cout << "numPEs: " << layerPEs << std::endl;
+      std::cout << "time: " << hit_time << std::endl;
+      std::cout << "z: " << hit_zpos << std::endl;
+      std::cout << "Layer: " << cur_layer << "\t Strip: " << cur_strip
+                << "\t X: " << hit_xpos << "\t Y: " << hit_ypos
+                << "\t Z: " << hit_zpos << std::endl;
     }  // end verbose
-  }    // end loop over map of values
+  }    // end loop over channels
+}
+
+float HcalDigiProducer::reconstructBarPosition(float pe_plus, float pe_minus,
+                                               float time_plus,
+                                               float time_minus) const {
+  // position from the time difference, with a constant variance
+  float time_position = 0.5 * strip_light_velocity_ * (time_minus - time_plus);
+  float time_variance = 0.5 * strip_light_velocity_ * strip_light_velocity_ *
+                        strip_time_resolution_ * strip_time_resolution_;
+
+  float total_pe = pe_plus + pe_minus;
+  if (total_pe <= 0) return time_position;
+
+  // position from the PE asymmetry, interpolated in the table
+  float bin = 0.5f * (pe_plus - pe_minus) / total_pe * position_table_size_ +
+              0.5f * position_table_size_;
+  int i = std::min(int(bin), position_table_size_ - 1);
+  float w = bin - i;
+  float pe_position =
+      (1 - w) * positionTable_[i] + w * positionTable_[i + 1];
+  float pe_variance = ((1 - w) * positionVarianceTable_[i] +
+                       w * positionVarianceTable_[i + 1]) /
+                      total_pe;
+
+  if (time_variance <= 0) return time_position;
+  return (pe_position * time_variance + time_position * pe_variance) /
+         (time_variance + pe_variance);
+}
+
+void HcalDigiProducer::sortAndIndex(std::vector<HcalHit>& hcalRecHits,
+                                    HcalHitIndex& index) {
+  // pack (section, layer, strip) into one key per hit so the channel is only
+  // decoded once
+  sortKeys_.clear();
+  for (unsigned int i = 0; i < hcalRecHits.size(); ++i) {
+    HcalID id(hcalRecHits[i].getID());
+    unsigned int key =
+        (unsigned(id.section()) << 16) | (unsigned(id.layer()) << 8) |
+        unsigned(id.strip());
+    sortKeys_.emplace_back(key, i);
+  }
+  std::sort(sortKeys_.begin(), sortKeys_.end());
+
+  sortedHits_.clear();
+  unsigned int prevLayerKey = 0;
+  for (const auto& [key, i] : sortKeys_) {
+    unsigned int layerKey = key >> 8;
+    if (sortedHits_.empty() || layerKey != prevLayerKey) {
+      index.addLayer(layerKey >> 8, layerKey & 0xFF, sortedHits_.size());
+      prevLayerKey = layerKey;
+    }
+    sortedHits_.push_back(hcalRecHits[i]);
+  }
+  index.setNumHits(sortedHits_.size());
+  hcalRecHits.swap(sortedHits_);
+}
+
+void HcalDigiProducer::NoiseModel::setMean(double mean) {
+  cdf.clear();
+  if (mean <= 0) {
+    probability = 0;
+    cdf.push_back(1.);
+    return;
+  }
+
+  probability = 1. - exp(-mean);
+  double term = exp(-mean), sum{0};
+  for (int k = 1; k < 100; ++k) {
+    term *= mean / k;
+    sum += term;
+    cdf.push_back(sum / probability);
+    if (cdf.back() >= 1. - 1e-12) break;
+  }
+  cdf.back() = 1.;
+}
+
+double HcalDigiProducer::NoiseModel::quantile(double u) const {
+  return std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin() + 1;
+}
+
+void HcalDigiProducer::drawNoise(int nBackEnds, int nSideTB, int nSideLR) {
+  // Only the ends with a PE are drawn: first their numbers, then their PE
+  // values and the back HCal positions as arrays of uniform numbers.
+  double p = noiseModel_.probability;
+  int nBack = (nBackEnds > 0) ? noiseRandom_->Binomial(nBackEnds, p) : 0;
+  int nTB = (nSideTB > 0) ? noiseRandom_->Binomial(nSideTB, p) : 0;
+  int nLR = (nSideLR > 0) ? noiseRandom_->Binomial(nSideLR, p) : 0;
+
+  int nNoise = nBack + nTB + nLR;
+  noiseUniforms_.resize(nNoise);
+  if (nNoise > 0) noiseRandom_->RndmArray(nNoise, noiseUniforms_.data());
+  for (int i = 0; i < nNoise; ++i)
+    noiseUniforms_[i] = noiseModel_.quantile(noiseUniforms_[i]);
+  const double* backPE = noiseUniforms_.data();
+  const double* sidePE = backPE + nBack;
+
+  // Each noisy back end gets a distinct slot among the empty ends, drawing
+  // the slots together and redrawing the duplicates until there are none.
+  // The two ends of a bar are neighbouring slots, so once sorted the ends of
+  // the same bar are next to each other. The PE values are independent of
+  // the slots, so they are assigned in sorted order. This is the same as
+  // shuffling the noise of every end, without touching the empty ones.
+  noiseSlots_.resize(nBack);
+  slotUniforms_.resize(nBack);
+  int nDraw = nBack;
+  while (nDraw > 0) {
+    noiseRandom_->RndmArray(nDraw, slotUniforms_.data());
+    for (int i = 0; i < nDraw; ++i) {
+      noiseSlots_[nBack - nDraw + i] = std::min(
+          static_cast<unsigned int>(slotUniforms_[i] * nBackEnds),
+          static_cast<unsigned int>(nBackEnds - 1));
+    }
+    std::sort(noiseSlots_.begin(), noiseSlots_.end());
+    nDraw = nBack - (std::unique(noiseSlots_.begin(), noiseSlots_.end()) -
+                     noiseSlots_.begin());
+  }
+
+  for (int i = 0; i < nBack; ++i) {
+    double cur_noise_pe_1 = backPE[i];
+    double cur_noise_pe_2 = 0;
+    if (i + 1 < nBack && noiseSlots_[i + 1] / 2 == noiseSlots_[i] / 2)
+      cur_noise_pe_2 = backPE[++i];
 
-  // ------------------------------- Noise simulation
-  // ------------------------------- simulate noise hits in back hcal
-  int total_super_strips_back = STRIPS_BACK_PER_LAYER_ / SUPER_STRIP_SIZE_;
-  int total_empty_channels =
-      2 * (total_super_strips_back * NUM_BACK_HCAL_LAYERS_ - numSigHits_back);
-  std::vector<double> noiseHits_PE = noiseGenerator_->generateNoiseHits(
-      total_empty_channels);  // 2-sided readout
-  int total_zero_channels = total_empty_channels - noiseHits_PE.size();
-
-  std::vector<double> zeroNoiseHits_PE(total_zero_channels, 0.0);
-  noiseHits_PE.insert(noiseHits_PE.end(), zeroNoiseHits_PE.begin(),
-                      zeroNoiseHits_PE.end());
-  std::random_shuffle(noiseHits_PE.begin(), noiseHits_PE.end());
-  int ctr_back_noise = 0;
-  for (unsigned i = 0; i < noiseHits_PE.size() / 2; ++i) {
-    double cur_noise_pe_1 = noiseHits_PE[i * 2];
-    double cur_noise_pe_2 = noiseHits_PE[i * 2 + 1];
     double total_noise = cur_noise_pe_1 + cur_noise_pe_2;
     if (total_noise < readoutThreshold_) continue;
+    noisePE_.push_back({total_noise, std::min(cur_noise_pe_1, cur_noise_pe_2)});
+  }
+  noiseOffsets_.push_back(noisePE_.size());
+
+  for (int i = 0; i < nTB; ++i) noisePE_.push_back({sidePE[i], sidePE[i]});
+  noiseOffsets_.push_back(noisePE_.size());
+  for (int i = nTB; i < nTB + nLR; ++i)
+    noisePE_.push_back({sidePE[i], sidePE[i]});
+  noiseOffsets_.push_back(noisePE_.size());
+}
+
+void HcalDigiProducer::drawScaledNoise(const ChannelDeposit* begin,
+                                       const ChannelDeposit* end) {
+  if (channelMask_) {
+    for (unsigned int id : channelMask_->getNoiseScaledIDs()) {
+      const ChannelDeposit* channel = std::lower_bound(
+          begin, end, id,
+          [](const ChannelDeposit& c, unsigned int i) { return c.id < i; });
+      if (channel != end && channel->id == id) continue;
+
+      // the back HCal is read out at both ends, the side HCal at one
+      double pe[2] = {0, 0};
+      int nEnds = (HcalID(id).getSection() == HcalID::BACK) ? 2 : 1;
+      for (int i = 0; i < nEnds; ++i) {
+        if (noiseRandom_->Rndm() < scaledNoiseModel_.probability)
+          pe[i] = scaledNoiseModel_.quantile(noiseRandom_->Rndm());
+      }
+
+      double total_noise = pe[0] + pe[1];
+      if (total_noise == 0 || (nEnds == 2 && total_noise < readoutThreshold_))
+        continue;
+      double min_noise = (nEnds == 2) ? std::min(pe[0], pe[1]) : total_noise;
+      noisePE_.push_back({total_noise, min_noise, id});
+    }
+  }
+  noiseOffsets_.push_back(noisePE_.size());
+}
+
+void HcalDigiProducer::produce(Event& event) {
+  std::vector<Event*> batch{&event};
+  produceBatch(batch);
+}
+
+void HcalDigiProducer::produceBatch(const std::vector<Event*>& events) {
+  seedGenerators();
+
+  // the mask is looked up once per batch
+  channelMask_ = nullptr;
+  if (use_channel_mask_) {
+    channelMask_ = &getCondition<HcalChannelMask>(
+        HcalChannelMask::CONDITIONS_OBJECT_NAME);
+
+    // the mask numbers the channels with its own copy of the layout
+    const int strips[HcalChannelMask::NUM_SECTIONS] = {
+        STRIPS_BACK_PER_LAYER_ / SUPER_STRIP_SIZE_, STRIPS_SIDE_TB_PER_LAYER_,
+        STRIPS_SIDE_TB_PER_LAYER_, STRIPS_SIDE_LR_PER_LAYER_,
+        STRIPS_SIDE_LR_PER_LAYER_};
+    const int layers[HcalChannelMask::NUM_SECTIONS] = {
+        NUM_BACK_HCAL_LAYERS_, NUM_SIDE_TB_HCAL_LAYERS_,
+        NUM_SIDE_TB_HCAL_LAYERS_, NUM_SIDE_LR_HCAL_LAYERS_,
+        NUM_SIDE_LR_HCAL_LAYERS_};
+    for (int section = 0; section < HcalChannelMask::NUM_SECTIONS; ++section) {
+      if (channelMask_->getNumStrips(section) != strips[section] ||
+          channelMask_->getNumLayers(section) != layers[section]) {
+        EXCEPTION_RAISE("InvalidArg",
+                        "The HcalChannelMask layout does not match the "
+                        "HcalDigiProducer, check the strips, layers and "
+                        "super strip size of both.");
+      }
+    }
+  }
 
-    double min_noise = std::min(cur_noise_pe_1, cur_noise_pe_2);
-    constructNoiseHit(hcalRecHits, HcalID::BACK, total_noise, min_noise,
-                      hcaldetIDEdep, noiseHitIDs);
-    ctr_back_noise++;
+  // aggregate the sim hits of the whole batch into one flat array, each event
+  // owning a contiguous range of channels sorted by ID
+  channels_.clear();
+  channelOffsets_.assign(1, 0);
+  pulses_.clear();
+  pulseOffsets_.assign(1, 0);
+  for (Event* event : events) {
+    std::size_t first = channels_.size();
+    std::size_t firstPulse = pulses_.size();
+    if (use_channel_deposits_) {
+      loadChannelDeposits(*event);
+    } else {
+      aggregateSimHits(*event);
+      if (write_channel_deposits_) writeChannelDeposits(*event, first);
+    }
+    mergeSuperStrips(first);
+    channelOffsets_.push_back(channels_.size());
+    if (waveform_mode_) sortPulses(firstPulse);
+    pulseOffsets_.push_back(pulses_.size());
   }
-  if (verbose_)
-    std::cout << "numSigHits_back = " << numSigHits_back
-              << ", ctr_back_noise = " << ctr_back_noise << std::endl;
-
-  // simulate noise hits in side, top / bottom hcal
-  noiseHits_PE = noiseGenerator_->generateNoiseHits(
-      (STRIPS_SIDE_TB_PER_LAYER_ * NUM_SIDE_TB_HCAL_LAYERS_) * 2 -
-      numSigHits_side_tb);
-  for (auto noise : noiseHits_PE) {
-    constructNoiseHit(hcalRecHits, HcalID::TOP, noise, noise, hcaldetIDEdep,
-                      noiseHitIDs);
-    constructNoiseHit(hcalRecHits, HcalID::BOTTOM, noise, noise, hcaldetIDEdep,
-                      noiseHitIDs);
+
+  // ------------------------------- Noise simulation
+  // The noise of the whole batch is drawn here, from its own generator, so
+  // drawing it before digitizing any signal keeps the sequence of random
+  // numbers the same as for one event at a time. Each event owns three
+  // consecutive ranges of noisePE_: back, side top / bottom and side left /
+  // right, then a fourth range for the noise-scaled channels.
+  // Dead and hot channels are neither signal nor empty channels, and
+  // noise-scaled channels are drawn on their own at their fixed IDs, so both
+  // are left out of the counts below.
+  int total_super_strips_back = STRIPS_BACK_PER_LAYER_ / SUPER_STRIP_SIZE_;
+  int excluded_back{0}, excluded_side_tb{0}, excluded_side_lr{0};
+  if (channelMask_) {
+    excluded_back = channelMask_->getNumMasked(HcalID::BACK) +
+                    channelMask_->getNumNoiseScaled(HcalID::BACK);
+    excluded_side_tb = channelMask_->getNumMasked(HcalID::TOP) +
+                       channelMask_->getNumMasked(HcalID::BOTTOM) +
+                       channelMask_->getNumNoiseScaled(HcalID::TOP) +
+                       channelMask_->getNumNoiseScaled(HcalID::BOTTOM);
+    excluded_side_lr = channelMask_->getNumMasked(HcalID::LEFT) +
+                       channelMask_->getNumMasked(HcalID::RIGHT) +
+                       channelMask_->getNumNoiseScaled(HcalID::LEFT) +
+                       channelMask_->getNumNoiseScaled(HcalID::RIGHT);
+    scaledNoiseModel_.setMean(meanNoise_ * channelMask_->getNoiseScale());
   }
+  noisePE_.clear();
+  noiseOffsets_.assign(1, 0);
+  emptyBackChannels_.clear();
+  for (std::size_t iEvent = 0; iEvent < events.size(); ++iEvent) {
+    int numSigHits_back = 0, numSigHits_side_tb = 0, numSigHits_side_lr = 0;
+    for (std::size_t i = channelOffsets_[iEvent];
+         i < channelOffsets_[iEvent + 1]; ++i) {
+      if (channelMask_ && (channelMask_->isMasked(channels_[i].id) ||
+                           channelMask_->isNoiseScaled(channels_[i].id)))
+        continue;
+      HcalID detID(channels_[i].id);
+      if (detID.getSection() == HcalID::BACK)
+        numSigHits_back++;
+      else if (detID.getSection() == HcalID::TOP ||
+               detID.getSection() == HcalID::BOTTOM)
+        numSigHits_side_tb++;
+      else if (detID.getSection() == HcalID::LEFT ||
+               detID.getSection() == HcalID::RIGHT)
+        numSigHits_side_lr++;
+      else
+        std::cout
+            << "WARNING [HcalDigiProducer::produce]: HcalSection is not known"
+            << std::endl;
+    }
 
-  // simulate noise hits in side, left / right hcal
-  noiseHits_PE = noiseGenerator_->generateNoiseHits(
-      (STRIPS_SIDE_LR_PER_LAYER_ * NUM_SIDE_LR_HCAL_LAYERS_) * 2 -
-      numSigHits_side_lr);
-  for (auto noise : noiseHits_PE) {
-    constructNoiseHit(hcalRecHits, HcalID::LEFT, noise, noise, hcaldetIDEdep,
-                      noiseHitIDs);
-    constructNoiseHit(hcalRecHits, HcalID::RIGHT, noise, noise, hcaldetIDEdep,
-                      noiseHitIDs);
+    // back hcal, 2-sided readout
+    int total_empty_channels =
+        2 * (total_super_strips_back * NUM_BACK_HCAL_LAYERS_ - numSigHits_back -
+             excluded_back);
+    emptyBackChannels_.push_back(total_empty_channels);
+    // side, top / bottom and left / right hcal
+    drawNoise(total_empty_channels,
+              (STRIPS_SIDE_TB_PER_LAYER_ * NUM_SIDE_TB_HCAL_LAYERS_) * 2 -
+                  numSigHits_side_tb - excluded_side_tb,
+              (STRIPS_SIDE_LR_PER_LAYER_ * NUM_SIDE_LR_HCAL_LAYERS_) * 2 -
+                  numSigHits_side_lr - excluded_side_lr);
+    drawScaledNoise(channels_.data() + channelOffsets_[iEvent],
+                    channels_.data() + channelOffsets_[iEvent + 1]);
   }
 
-  event.add("HcalRecHits", hcalRecHits);
+  // split the batch back into one collection per event
+  for (std::size_t iEvent = 0; iEvent < events.size(); ++iEvent) {
+    const ChannelDeposit* begin = channels_.data() + channelOffsets_[iEvent];
+    const ChannelDeposit* end = channels_.data() + channelOffsets_[iEvent + 1];
+
+    const Pulse* pulseBegin = pulses_.data() + pulseOffsets_[iEvent];
+    const Pulse* pulseEnd = pulses_.data() + pulseOffsets_[iEvent + 1];
+
+    std::vector<HcalHit> hcalRecHits;
+    std::vector<HcalWaveform> waveforms;
+    digitizeChannels(begin, end, pulseBegin, pulseEnd, hcalRecHits, waveforms);
+
+    signalIDs_.clear();
+    for (const ChannelDeposit* channel = begin; channel != end; ++channel)
+      signalIDs_.push_back(channel->id);
+    std::unordered_set<unsigned int> noiseHitIDs;
+
+    // simulate noise hits in back hcal
+    const std::size_t* offsets = &noiseOffsets_[4 * iEvent];
+    int total_empty_channels = emptyBackChannels_[iEvent];
+    int ctr_back_noise = 0;
+    for (std::size_t i = offsets[0]; i < offsets[1]; ++i) {
+      constructNoiseHit(hcalRecHits, HcalID::BACK, noisePE_[i].pe,
+                        noisePE_[i].minPE, signalIDs_, noiseHitIDs);
+      ctr_back_noise++;
+    }
+    if (verbose_)
+      std::cout << "numSigHits_back = "
+                << total_super_strips_back * NUM_BACK_HCAL_LAYERS_ -
+                       excluded_back - total_empty_channels / 2
+                << ", ctr_back_noise = " << ctr_back_noise << std::endl;
+
+    // simulate noise hits in side, top / bottom hcal
+    for (std::size_t i = offsets[1]; i < offsets[2]; ++i) {
+      constructNoiseHit(hcalRecHits, HcalID::TOP, noisePE_[i].pe,
+                        noisePE_[i].minPE, signalIDs_, noiseHitIDs);
+      constructNoiseHit(hcalRecHits, HcalID::BOTTOM, noisePE_[i].pe,
+                        noisePE_[i].minPE, signalIDs_, noiseHitIDs);
+    }
+
+    // simulate noise hits in side, left / right hcal
+    for (std::size_t i = offsets[2]; i < offsets[3]; ++i) {
+      constructNoiseHit(hcalRecHits, HcalID::LEFT, noisePE_[i].pe,
+                        noisePE_[i].minPE, signalIDs_, noiseHitIDs);
+      constructNoiseHit(hcalRecHits, HcalID::RIGHT, noisePE_[i].pe,
+                        noisePE_[i].minPE, signalIDs_, noiseHitIDs);
+    }
+
+    // noise of the noise-scaled channels, at their own IDs
+    for (std::size_t i = offsets[3]; i < offsets[4]; ++i) {
+      constructNoiseHit(hcalRecHits, noisePE_[i].id, noisePE_[i].pe,
+                        noisePE_[i].minPE, noiseHitIDs);
+    }
+
+    HcalHitIndex index;
+    sortAndIndex(hcalRecHits, index);
+
+    events[iEvent]->add("HcalRecHits", hcalRecHits);
+    events[iEvent]->add("HcalRecHitIndex", index);
+    if (waveform_mode_) events[iEvent]->add("HcalWaveforms", waveforms);
+  }
 }
 
 }  // namespace ldmx
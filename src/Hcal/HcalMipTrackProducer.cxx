@@ -0,0 +1,216 @@
+/**
+ * @file HcalMipTrackProducer.cxx
+ * @brief Producer that finds straight MIP tracks in the back HCal.
+ */
+
+#include "Hcal/HcalMipTrackProducer.h"
+
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+//-------------//
+//   ldmx-sw   //
+//-------------//
+#include "DetDescr/HcalID.h"
+#include "Framework/Exception/Exception.h"
+#include "Hcal/Event/HcalHitIndex.h"
+
+namespace ldmx {
+
+HcalMipTrackProducer::HcalMipTrackProducer(const std::string &name,
+                                           Process &process)
+    : Producer(name, process) {}
+
+HcalMipTrackProducer::~HcalMipTrackProducer() {}
+
+void HcalMipTrackProducer::configure(Parameters &parameters) {
+  hit_pass_name_ = parameters.getParameter<std::string>("hit_pass_name");
+  minPE_ = parameters.getParameter<double>("min_pe");
+  z0_ = parameters.getParameter<double>("z0");
+  maxSlope_ = parameters.getParameter<double>("max_slope");
+  maxIntercept_ = parameters.getParameter<double>("max_intercept");
+  nSlopeBins_ = parameters.getParameter<int>("n_slope_bins");
+  nInterceptBins_ = parameters.getParameter<int>("n_intercept_bins");
+  roadWidth_ = parameters.getParameter<double>("road_width");
+  minLayers_ = parameters.getParameter<int>("min_layers");
+  maxTracks_ = parameters.getParameter<int>("max_tracks");
+
+  // every hit voting in a bin is within half a bin of its center line, so
+  // this road keeps all the layers that make a peak
+  if (roadWidth_ < maxIntercept_ / nInterceptBins_) {
+    EXCEPTION_RAISE("InvalidArg",
+                    "road_width must be at least half an intercept bin, "
+                    "max_intercept / n_intercept_bins.");
+  }
+
+  // the accumulator has a fixed size, allocate it once
+  slopes_.resize(nSlopeBins_);
+  float slopeBinWidth = 2 * maxSlope_ / nSlopeBins_;
+  for (int i = 0; i < nSlopeBins_; ++i)
+    slopes_[i] = -maxSlope_ + (i + 0.5) * slopeBinWidth;
+  accumulator_.assign(nSlopeBins_ * nInterceptBins_, 0);
+  voter_.assign(nSlopeBins_ * nInterceptBins_, -1);
+}
+
+void HcalMipTrackProducer::fillAccumulator(const std::vector<ViewHit> &hits) {
+  std::fill(accumulator_.begin(), accumulator_.end(), 0);
+  std::fill(voter_.begin(), voter_.end(), -1);
+
+  // the hits of a layer are next to each other, so remembering the last layer
+  // that voted in a bin is enough to give each layer a single vote
+  float interceptScale = nInterceptBins_ / (2 * maxIntercept_);
+  for (const ViewHit &hit : hits) {
+    if (hit.used) continue;
+    float dz = hit.z - z0_;
+    for (int i = 0; i < nSlopeBins_; ++i) {
+      float intercept = hit.u - slopes_[i] * dz;
+      int bin = int(std::floor((intercept + maxIntercept_) * interceptScale));
+      if (bin < 0 || bin >= nInterceptBins_) continue;
+      int cell = i * nInterceptBins_ + bin;
+      if (voter_[cell] == hit.layer) continue;
+      voter_[cell] = hit.layer;
+      ++accumulator_[cell];
+    }
+  }
+}
+
+void HcalMipTrackProducer::findTracks(std::vector<ViewHit> &hits,
+                                      std::vector<ViewTrack> &tracks) {
+  fillAccumulator(hits);
+
+  float interceptBinWidth = 2 * maxIntercept_ / nInterceptBins_;
+  int nFound{0};
+  while (nFound < maxTracks_) {
+    // the peak is the bin with the most layers
+    auto peak = std::max_element(accumulator_.begin(), accumulator_.end());
+    if (*peak < minLayers_) break;
+
+    int bin = peak - accumulator_.begin();
+    float slope = slopes_[bin / nInterceptBins_];
+    float u0 =
+        -maxIntercept_ + (bin % nInterceptBins_ + 0.5) * interceptBinWidth;
+
+    // collect the unused hits in the road
+    roadHits_.clear();
+    std::bitset<256> layers;
+    for (unsigned int i = 0; i < hits.size(); ++i) {
+      const ViewHit &hit = hits[i];
+      if (hit.used) continue;
+      if (std::fabs(hit.u - (u0 + slope * (hit.z - z0_))) > roadWidth_)
+        continue;
+      roadHits_.push_back(i);
+      layers.set(hit.layer & 0xFF);
+    }
+
+    // fit the road hits with a straight line
+    double sw{0}, sz{0}, su{0}, szz{0}, szu{0};
+    ViewTrack track{0, 0, 0, 0, 0, 0, 0, 0};
+    track.zMin = 1e9;
+    track.zMax = -1e9;
+    track.firstLayer = 256;
+    track.lastLayer = -1;
+    track.nLayers = layers.count();
+    for (unsigned int i : roadHits_) {
+      ViewHit &hit = hits[i];
+      hit.used = true;
+
+      float dz = hit.z - z0_;
+      sw += 1;
+      sz += dz;
+      su += hit.u;
+      szz += dz * dz;
+      szu += dz * hit.u;
+      track.pe += hit.pe;
+      track.zMin = std::min(track.zMin, hit.z);
+      track.zMax = std::max(track.zMax, hit.z);
+      track.firstLayer = std::min(track.firstLayer, hit.layer);
+      track.lastLayer = std::max(track.lastLayer, hit.layer);
+    }
+
+    double det = sw * szz - sz * sz;
+    if (det > 0) {
+      track.slope = (sw * szu - sz * su) / det;
+      track.u0 = (su - track.slope * sz) / sw;
+    } else {
+      track.slope = slope;
+      track.u0 = u0;
+    }
+    tracks.push_back(track);
+    ++nFound;
+
+    // vote again without the hits of the track
+    fillAccumulator(hits);
+  }
+}
+
+void HcalMipTrackProducer::produce(Event &event) {
+  const std::vector<HcalHit> hcalRecHits =
+      event.getCollection<HcalHit>("HcalRecHits", hit_pass_name_);
+  const HcalHitIndex &index =
+      event.getObject<HcalHitIndex>("HcalRecHitIndex", hit_pass_name_);
+
+  // only the back HCal hits are needed, jump straight to them. They are
+  // sorted by layer, which the accumulator relies on.
+  hitsX_.clear();
+  hitsY_.clear();
+  HcalHitIndex::Range back = index.getSectionRange(HcalID::BACK);
+  for (unsigned int i = back.first; i < back.second; ++i) {
+    const HcalHit &hcalHit = hcalRecHits[i];
+
+    // noise hits carry no position
+    if (hcalHit.isNoise() || hcalHit.getPE() < minPE_) continue;
+
+    // even layers are vertical bars measuring x, odd layers are horizontal
+    // bars measuring y
+    HcalID id(hcalHit.getID());
+    if (id.layer() % 2 == 0)
+      hitsX_.push_back({hcalHit.getZPos(), hcalHit.getXPos(), hcalHit.getPE(),
+                        id.layer(), false});
+    else
+      hitsY_.push_back({hcalHit.getZPos(), hcalHit.getYPos(), hcalHit.getPE(),
+                        id.layer(), false});
+  }
+
+  tracksX_.clear();
+  tracksY_.clear();
+  findTracks(hitsX_, tracksX_);
+  findTracks(hitsY_, tracksY_);
+
+  // pair each x candidate, best first, with the y candidate it overlaps most
+  // in z
+  std::vector<HcalMipTrack> tracks;
+  std::vector<bool> pairedY(tracksY_.size(), false);
+  for (const ViewTrack &trackX : tracksX_) {
+    int best{-1};
+    float bestOverlap{0};
+    for (unsigned int i = 0; i < tracksY_.size(); ++i) {
+      if (pairedY[i]) continue;
+      float overlap = std::min(trackX.zMax, tracksY_[i].zMax) -
+                      std::max(trackX.zMin, tracksY_[i].zMin);
+      if (overlap > bestOverlap) {
+        bestOverlap = overlap;
+        best = i;
+      }
+    }
+    if (best < 0) continue;
+    pairedY[best] = true;
+
+    const ViewTrack &trackY = tracksY_[best];
+    HcalMipTrack track;
+    track.setParameters(z0_, trackX.u0, trackY.u0, trackX.slope, trackY.slope);
+    track.setLayers(trackX.nLayers, trackY.nLayers,
+                    std::min(trackX.firstLayer, trackY.firstLayer),
+                    std::max(trackX.lastLayer, trackY.lastLayer));
+    track.setPE(trackX.pe + trackY.pe);
+    tracks.push_back(track);
+  }
+
+  event.add("HcalMipTracks", tracks);
+}
+}  // namespace ldmx
+
+DECLARE_PRODUCER_NS(ldmx, HcalMipTrackProducer);
@@ -11,6 +11,11 @@
 //-------------//
 #include "DetDescr/HcalID.h"
 
+//----------------//
+//   C++ StdLib   //
+//----------------//
+#include <algorithm>
+
 namespace ldmx {
 
 HcalVetoProcessor::HcalVetoProcessor(const std::string &name, Process &process)
@@ -23,6 +28,7 @@ void HcalVetoProcessor::configure(Parameters &parameters) {
   maxTime_ = parameters.getParameter<double>("max_time");
   maxDepth_ = parameters.getParameter<double>("max_depth");
   minPE_ = parameters.getParameter<double>("back_min_pe");
+  useChannelMask_ = parameters.getParameter<bool>("use_channel_mask");
 }
 
 void HcalVetoProcessor::produce(Event &event) {
@@ -30,45 +36,97 @@ void HcalVetoProcessor::produce(Event &event) {
   const std::vector<HcalHit> hcalRecHits =
       event.getCollection<HcalHit>("HcalRecHits");
 
-  // Loop over all of the Hcal hits and calculate to total photoelectrons
-  // in the event.
+  const HcalChannelMask *channelMask{nullptr};
+  if (useChannelMask_) {
+    channelMask = &getCondition<HcalChannelMask>(
+        HcalChannelMask::CONDITIONS_OBJECT_NAME);
+  }
+
+  // Gather the hits into columns, padded to a whole number of lanes with
+  // hits that fail the time cut.
+  const std::size_t nHits = hcalRecHits.size();
+  const std::size_t nPadded = (nHits + LANES - 1) / LANES * LANES;
+  hitPE_.assign(nPadded, 0);
+  hitMinPE_.assign(nPadded, 0);
+  hitTime_.assign(nPadded, maxTime_);
+  hitZ_.assign(nPadded, 0);
+  hitBack_.assign(nPadded, 0);
+  hitMasked_.assign(nPadded, 0);
+  for (std::size_t i = 0; i < nHits; ++i) {
+    const HcalHit &hcalHit = hcalRecHits[i];
+    hitPE_[i] = hcalHit.getPE();
+    hitMinPE_[i] = hcalHit.getMinPE();
+    hitTime_[i] = hcalHit.getTime();
+    hitZ_[i] = hcalHit.getZPos();
+    hitBack_[i] = HcalID(hcalHit.getID()).section() == HcalID::BACK;
+    if (channelMask) hitMasked_[i] = channelMask->isMasked(hcalHit.getID());
+  }
+
+  // Evaluate the cuts as 0 / 1 factors and reduce LANES hits at a time, each
+  // lane keeping its own total, maximum and index of the maximum so the
+  // inner loop has no dependency between hits and no branches. The cuts are
+  // kept in separate float variables and the index is updated with integer
+  // arithmetic, which lets GCC if-convert and vectorize the lane loop.
+  //  - Dead and hot channels are not considered.
+  //  - Hits outside the readout window or beyond the maximum HCal depth are
+  //    not considered.
+  //  - Every other hit counts towards the total PE, but only hits with a PE
+  //    value above threshold on both sides of the bar can be the maximum.
+  //    Double sided readout is only being used for the back HCal bars, for
+  //    the side HCal just use the maximum PE as before.
+  const float *pe = hitPE_.data();
+  const float *minPE = hitMinPE_.data();
+  const float *time = hitTime_.data();
+  const float *z = hitZ_.data();
+  const float *back = hitBack_.data();
+  const float *masked = hitMasked_.data();
+  const float maxTime = maxTime_, maxDepth = maxDepth_, minPECut = minPE_;
+  float laneTotalPE[LANES] = {0};
+  float laneMaxPE[LANES];
+  int laneMaxIndex[LANES] = {0};
+  std::fill(laneMaxPE, laneMaxPE + LANES, NO_HIT_PE);
+  for (std::size_t block = 0; block < nPadded; block += LANES) {
+    for (int lane = 0; lane < LANES; ++lane) {
+      std::size_t i = block + lane;
+      float inTime = time[i] < maxTime;
+      float inDepth = z[i] <= maxDepth;
+      float lowEnd = minPE[i] < minPECut;
+      float selected = (1.f - masked[i]) * inTime * inDepth;
+      float candidate = selected * (1.f - back[i] * lowEnd);
+      float candidatePE = candidate * pe[i] + (1.f - candidate) * NO_HIT_PE;
+      laneTotalPE[lane] += selected * pe[i];
+      int larger = candidatePE > laneMaxPE[lane];
+      laneMaxIndex[lane] += larger * (int(i) - laneMaxIndex[lane]);
+      laneMaxPE[lane] = std::max(laneMaxPE[lane], candidatePE);
+    }
+  }
+
+  // Each lane holds the first of its hits with its maximum PE, so the first
+  // hit overall is the one with the lowest index among the lanes that share
+  // the maximum.
   float totalPe{0};
-  float maxPE{-1000};
-  const HcalHit *maxPEHit;
-  for (const HcalHit &hcalHit : hcalRecHits) {
-    // If the hit time is outside the readout window, don't consider it.
-    if (hcalHit.getTime() >= maxTime_) continue;
-
-    // If the hit z position is beyond the maximum HCal depth, skip it.
-    if (hcalHit.getZPos() > maxDepth_) continue;
-
-    // Get the total PE in the bar
-    float pe = hcalHit.getPE();
-
-    // Keep track of the total PE
-    totalPe += pe;
-
-    // Check that both sides of the bar have a PE value above threshold.
-    // If not, don't consider the hit.  Double sided readout is only
-    // being used for the back HCal bars.  For the side HCal, just
-    // use the maximum PE as before.
-    HcalID id(hcalHit.getID());
-    if ((id.section() == HcalID::BACK) && (hcalHit.getMinPE() < minPE_))
-      continue;
-
-    // Find the maximum PE in the list
-    if (maxPE < pe) {
-      maxPE = pe;
-      maxPEHit = &hcalHit;
+  float maxPE{NO_HIT_PE};
+  int iMax{0};
+  for (int lane = 0; lane < LANES; ++lane) {
+    totalPe += laneTotalPE[lane];
+    if (laneMaxPE[lane] > maxPE ||
+        (laneMaxPE[lane] == maxPE && laneMaxIndex[lane] < iMax)) {
+      maxPE = laneMaxPE[lane];
+      iMax = laneMaxIndex[lane];
     }
   }
 
+  // If no hit passes the cuts, the event passes the veto and the default
+  // HcalHit is stored.
+  HcalHit maxPEHit;
+  if (maxPE > NO_HIT_PE) maxPEHit = hcalRecHits[iMax];
+
   // If the maximum PE found is below threshold, it passes the veto.
   bool passesVeto = (maxPE < totalPEThreshold_);
 
   HcalVetoResult result;
   result.setVetoResult(passesVeto);
-  result.setMaxPEHit(*maxPEHit);
+  result.setMaxPEHit(maxPEHit);
 
   if (passesVeto) {
     setStorageHint(hint_shouldKeep);